@@ -1,4 +1,6 @@
 #include "EEPROM.h"
+#include "EEPROM_Trace.h"
+#include "EEPROM_Capture.h"
 
 static EEPROM_Status decodeStatusHAL(HAL_StatusTypeDef status) {
     switch (status) {
@@ -22,16 +24,207 @@ do { \
     } \
 } while (0)
 
+#if EEPROM_TRACE_ENABLED
+#define TRACE(event, address, info) EEPROM_Trace_record(event, address, getTraceInfo(info))
+#else
+#define TRACE(event, address, info) do {} while (0)
+#endif
+
+#if EEPROM_CAPTURE_ENABLED
+#define CAPTURE(kind, page, size, offset) EEPROM_Capture_record(kind, (mConfig.deviceAddress >> 1) & 0x07, page, size, offset)
+#else
+#define CAPTURE(kind, page, size, offset) do {} while (0)
+#endif
+
+static auto sSleepOnWait = false;
+
+static void waitFor(uint32_t delay) {
+    if(!sSleepOnWait) {
+        HAL_Delay(delay);
+        return;
+    }
+    if(delay == 0) {
+        return;
+    }
+    // SysTick wakes the core every tick, one extra tick guarantees the full delay like HAL_Delay
+    auto start = HAL_GetTick();
+    while(HAL_GetTick() - start <= delay) {
+        __WFI();
+    }
+}
+
+enum OperationType : uint8_t {
+    OperationType_Read,
+    OperationType_Write,
+    OperationType_ReadRaw,
+    OperationType_WriteRaw
+};
+
+static auto isWriteOperation(const EEPROM_Operation& operation) {
+    return operation.type == OperationType_Write || operation.type == OperationType_WriteRaw;
+}
+
+static auto usesCRC(const EEPROM_Operation& operation) {
+    return operation.type == OperationType_Read || operation.type == OperationType_Write;
+}
+
+enum OperationStage : uint8_t {
+    OperationStage_Queued,
+    OperationStage_DataTransfer,
+    OperationStage_DataWriteCycle,
+    OperationStage_CRCTransfer,
+    OperationStage_CRCWriteCycle
+};
+
+class EEPROM;
+
+// Records whose CRC was checked since boot, for EEPROM_Integrity_Lazy. The pages
+// run from the first data page to the CRC page.
+struct VerifiedRecord {
+    const EEPROM* device;
+    uint16_t page;
+    uint16_t lastPage;
+    uint16_t size;
+    bool isUsed;
+};
+
+static VerifiedRecord sVerifiedRecords[EEPROM_VERIFIED_RECORDS];
+
+static auto findVerified(const EEPROM* device, uint16_t page) -> VerifiedRecord* {
+    for(auto& record : sVerifiedRecords) {
+        if(record.isUsed && record.device == device && record.page == page) {
+            return &record;
+        }
+    }
+    return nullptr;
+}
+
+// A full table leaves the record unmarked, it is checked again on the next read
+static void markVerified(const EEPROM* device, uint16_t page, uint16_t lastPage, uint16_t size) {
+    auto record = findVerified(device, page);
+    for(auto& free : sVerifiedRecords) {
+        if(record == nullptr && !free.isUsed) {
+            record = &free;
+        }
+    }
+    if(record != nullptr) {
+        *record = VerifiedRecord{device, page, lastPage, size, true};
+    }
+}
+
+// Every record of the device overlapping the pages
+static void forgetVerified(const EEPROM* device, uint16_t page, uint16_t lastPage) {
+    for(auto& record : sVerifiedRecords) {
+        if(record.isUsed && record.device == device && record.page <= lastPage && page <= record.lastPage) {
+            record.isUsed = false;
+        }
+    }
+}
+
+// Tells the write observers, defined with the device table
+static void notifyWritten(const EEPROM* device, uint16_t page, uint16_t lastPage);
+
+// Devices sharing one I2C peripheral. A device owns the bus only for the
+// duration of a transfer or an ACK poll, so the other chips can be served
+// while one of them is busy with its internal write cycle.
+class Bus {
+public:
+    auto getHandle() const {
+        return mHandle;
+    }
+
+    auto attach(I2C_HandleTypeDef* handle, EEPROM* device) {
+        if(mHandle != nullptr && mHandle != handle) {
+            return false;
+        }
+        for(uint8_t i = 0; i < mCount; ++i) {
+            if(mDevices[i] == device) {
+                return true;
+            }
+        }
+        if(mCount == EEPROM_MAX_DEVICES) {
+            return false;
+        }
+        if(mHandle == nullptr) {
+            mBaseTiming = handle->Init.Timing;
+        }
+        mHandle = handle;
+        mDevices[mCount++] = device;
+        return true;
+    }
+
+    void detach(EEPROM* device) {
+        for(uint8_t i = 0; i < mCount; ++i) {
+            if(mDevices[i] == device) {
+                mDevices[i] = mDevices[--mCount];
+                break;
+            }
+        }
+        if(mOwner == device) {
+            mOwner = nullptr;
+        }
+        if(mCount == 0) {
+            mHandle = nullptr;
+        }
+    }
+
+    auto acquire(const EEPROM* device) {
+        if(mOwner != nullptr && mOwner != device) {
+            return false;
+        }
+        mOwner = device;
+        return true;
+    }
+
+    void release(const EEPROM* device) {
+        if(mOwner == device) {
+            mOwner = nullptr;
+        }
+    }
+
+    auto getBaseTiming() const {
+        return mBaseTiming;
+    }
+
+    // Re-initializes the peripheral, only between transfers
+    auto setTiming(uint32_t timing) {
+        if(mHandle->Init.Timing == timing) {
+            return true;
+        }
+        if(HAL_I2C_GetState(mHandle) != HAL_I2C_STATE_READY) {
+            return false;
+        }
+        mHandle->Init.Timing = timing;
+        return HAL_I2C_Init(mHandle) == HAL_OK;
+    }
+
+    void step();
+
+private:
+    I2C_HandleTypeDef* mHandle{};
+    uint32_t mBaseTiming{};
+    const EEPROM* mOwner{};
+    EEPROM* mDevices[EEPROM_MAX_DEVICES]{};
+    uint8_t mCount{};
+    uint8_t mNext{};
+};
 
 class EEPROM {            
     static constexpr auto sTimeout = 50;
     static constexpr auto sWriteDelay = 5;    
+    static constexpr auto sWriteCycleTimeout = 10;
 public:
     auto init(const EEPROM_Config& config) {   
         if(config.hI2C == nullptr || config.hCRC == nullptr || config.pageSize == 0) {
             return EEPROM_Status_NotInitialized;
         }     
         mConfig = config;
+        mIsBulkFailed = false;
+        mRecoveries = 0;
+        mRecoveriesTotal = 0;
+        for(auto& stats : mSpeedStats) {
+            stats = EEPROM_SpeedStats{};
+        }
         return EEPROM_Status_Sucess;
     }   
 
@@ -39,10 +232,154 @@ public:
         return mConfig.hI2C != nullptr && mConfig.hCRC != nullptr;
     }
 
-    auto write(uint16_t page, uint8_t* buffer, uint16_t size, bool useCRC) const {               
+    auto isIdle() const {
+        return mHead == nullptr;
+    }
+
+    auto getBus() const {
+        return mBus;
+    }
+
+    void setBus(Bus* bus) {
+        mBus = bus;
+    }
+
+    auto write(uint16_t page, uint8_t* buffer, uint16_t size, bool useCRC) {               
+        TRACE(EEPROM_TraceEvent_WriteStart, page, 0);
+        forgetWritten(page, 0, size, useCRC);
+        CAPTURE(useCRC ? EEPROM_CaptureKind_Write : EEPROM_CaptureKind_WriteRaw, page, size, 0);
+        auto status = writeRecord(page, buffer, size, useCRC);
+        TRACE(EEPROM_TraceEvent_OperationEnd, page, status);
+        return status;
+    }
+
+    auto read(int16_t page, uint8_t* buffer, uint16_t size, bool useCRC) {
+        TRACE(EEPROM_TraceEvent_ReadStart, page, 0);
+        CAPTURE(useCRC ? EEPROM_CaptureKind_Read : EEPROM_CaptureKind_ReadRaw, page, size, 0);
+        auto status = readRecord(page, buffer, size, useCRC);
+        TRACE(EEPROM_TraceEvent_OperationEnd, page, status);
+        return status;
+    }
+
+    // Blocking like write(): reads the old bytes of the range and the stored CRC, writes the new
+    // bytes and the patched CRC. The arguments are checked by EEPROM_PatchDevice().
+    auto patch(uint16_t page, uint16_t recordSize, uint16_t offset, const uint8_t* bytes, uint16_t size) -> EEPROM_Status {
+        if(!isInitialized()) {
+            return EEPROM_Status_NotInitialized;
+        }
+        if(!isIdle()) {
+            return EEPROM_Status_Busy;
+        }
+        auto address = static_cast<uint16_t>(getPageMemoryAddress(page) + offset);
+        auto crcPage = getCRCPage(page, recordSize);
+        uint8_t oldBytes[EEPROM_PATCH_MAX_SIZE];
+        uint32_t crc{};
+        RETURN_IF_ERROR(readBytes(address, oldBytes, size));
+        RETURN_IF_ERROR(readCRC(crcPage, crc));
+        auto isChanged = false;
+        for(uint16_t i = 0; i < size; ++i) {
+            isChanged = isChanged || oldBytes[i] != bytes[i];
+        }
+        if(!isChanged) {
+            return EEPROM_Status_Sucess;
+        }
+        TRACE(EEPROM_TraceEvent_WriteStart, page, 0);
+        forgetWritten(page, 0, recordSize, true);
+        auto patchedCRC = EEPROM_patchCRC(mConfig.hCRC, crc, recordSize, offset, oldBytes, bytes, size);
+        auto status = decodeStatusHAL(writeBytes(address, const_cast<uint8_t*>(bytes), size));
+        if(status == EEPROM_Status_Sucess) {
+            status = decodeStatusHAL(writeBytes(getPageMemoryAddress(crcPage), reinterpret_cast<uint8_t*>(&patchedCRC), 
+                                                sizeof(patchedCRC)));
+        }
+        TRACE(EEPROM_TraceEvent_OperationEnd, page, status);
+        return status;
+    }
+
+    auto getConfig() const -> const EEPROM_Config& {
+        return mConfig;
+    }
+
+    auto getSpeedStats(uint8_t speed) const -> const EEPROM_SpeedStats& {
+        return mSpeedStats[speed];
+    }
+
+    auto isBulkTimingActive() const {
+        return mConfig.bulkTiming != 0 && !mIsBulkFailed;
+    }
+
+    auto getBusRecoveries() const {
+        return mRecoveriesTotal;
+    }
+
+    auto getCountOfPagesFor(uint16_t bufferSize) const -> uint16_t {
+        return bufferSize / mConfig.pageSize + 1;
+    }
+
+    auto getCRCPage(uint16_t page, uint16_t size) const -> uint16_t {
+        return static_cast<uint16_t>(page + getCountOfPagesFor(size));
+    }
+
+    // The write makes the lazily verified records it touches untrusted, even if it fails half way,
+    // and the copies the observers keep of its pages stale
+    void forgetWritten(uint16_t page, uint16_t offset, uint16_t size, bool useCRC) const {
+        auto lastPage = useCRC ? getCRCPage(page, size) : page + (offset + (size != 0 ? size - 1 : 0)) / mConfig.pageSize;
+        forgetVerified(this, page, static_cast<uint16_t>(lastPage));
+        notifyWritten(this, page, static_cast<uint16_t>(lastPage));
+    }
+
+    auto submit(EEPROM_Operation& operation, OperationType type, 
+                uint16_t page, uint8_t* buffer, uint16_t size, uint16_t offset = 0) -> EEPROM_Status {
+        if(!isInitialized()) {
+            return EEPROM_Status_NotInitialized;
+        }
+        if(operation.status == EEPROM_Status_Pending) {
+            return EEPROM_Status_Busy;
+        }
+        operation.next = nullptr;
+        operation.bytes = buffer;
+        operation.page = page;
+        operation.offset = offset;
+        operation.size = size;
+        operation.processed = 0;
+        operation.type = type;
+        operation.stage = OperationStage_Queued;
+        operation.status = EEPROM_Status_Pending;
+        if(isWriteOperation(operation)) {
+            forgetWritten(page, offset, size, usesCRC(operation));
+        }
+        TRACE(isWriteOperation(operation) ? EEPROM_TraceEvent_WriteStart : EEPROM_TraceEvent_ReadStart, page, 0);
+        // Capture kinds follow OperationType
+        CAPTURE(type | EEPROM_CaptureKind_Async, page, size, offset);
+        if(mTail != nullptr) {
+            mTail->next = &operation;
+        } else {
+            mHead = &operation;
+        }
+        mTail = &operation;
+        return EEPROM_Status_Sucess;
+    }
+
+    // Never waits: starts a transfer or polls the chip and returns.
+    void step() {
+        while(mHead != nullptr && advance(*mHead)) {
+            if(mHead->status != EEPROM_Status_Pending) {
+                mHead = mHead->next;
+                if(mHead == nullptr) {
+                    mTail = nullptr;
+                }
+            }
+        }
+    }
+    
+private:    
+
+    auto writeRecord(uint16_t page, uint8_t* buffer, uint16_t size, bool useCRC) -> EEPROM_Status {
         if(!isInitialized()) {
             return EEPROM_Status_NotInitialized;
         }    
+        if(!isIdle()) {
+            return EEPROM_Status_Busy;
+        }
         RETURN_IF_ERROR(writeBuffer(page, buffer, size));
         if(!useCRC) {
             return EEPROM_Status_Sucess;
@@ -51,10 +388,13 @@ public:
         return EEPROM_Status_Sucess;
     }
 
-    auto read(int16_t page, uint8_t* buffer, uint16_t size, bool useCRC) const {
+    auto readRecord(int16_t page, uint8_t* buffer, uint16_t size, bool useCRC) -> EEPROM_Status {
         if(!isInitialized()) {
             return EEPROM_Status_NotInitialized;
         }
+        if(!isIdle()) {
+            return EEPROM_Status_Busy;
+        }
         RETURN_IF_ERROR(readBuffer(page, buffer, size));        
         if(!useCRC) {
             return EEPROM_Status_Sucess;
@@ -67,31 +407,323 @@ public:
         return EEPROM_Status_Sucess;
     }
 
-    auto getCountOfPagesFor(uint16_t bufferSize) const -> uint16_t {
-        return bufferSize / mConfig.pageSize + 1;
+    // Returns false while the operation waits for the bus or for the write cycle.
+    auto advance(EEPROM_Operation& operation) -> bool {
+        switch(operation.stage) {
+            case OperationStage_Queued:
+                return startNextChunk(operation);
+            case OperationStage_DataTransfer:
+                if(!isTransferComplete(operation)) {
+                    return false;
+                }
+                if(operation.status != EEPROM_Status_Pending) {
+                    return true;
+                }
+                operation.processed += getChunkSize(operation);
+                if(isWriteOperation(operation)) {
+                    return startWriteCycle(operation, OperationStage_DataWriteCycle);
+                }
+                return startNextChunk(operation);
+            case OperationStage_DataWriteCycle:
+                if(!isWriteCycleComplete(operation)) {
+                    return false;
+                }
+                return startNextChunk(operation);
+            case OperationStage_CRCTransfer:
+                if(!isTransferComplete(operation)) {
+                    return false;
+                }
+                if(operation.status != EEPROM_Status_Pending) {
+                    return true;
+                }
+                if(isWriteOperation(operation)) {
+                    return startWriteCycle(operation, OperationStage_CRCWriteCycle);
+                }
+                if(operation.crc != calcCRC(operation.bytes, operation.size)) {
+                    return complete(operation, EEPROM_Status_InvalidCRC);
+                }
+                return complete(operation, EEPROM_Status_Sucess);
+            case OperationStage_CRCWriteCycle:
+                if(!isWriteCycleComplete(operation)) {
+                    return false;
+                }
+                return complete(operation, EEPROM_Status_Sucess);
+            default:
+                break;
+        }
+        return complete(operation, EEPROM_Status_Error);
+    }
+
+    auto startNextChunk(EEPROM_Operation& operation) -> bool {
+        if(operation.processed >= operation.size && !usesCRC(operation)) {
+            return complete(operation, EEPROM_Status_Sucess);
+        }
+        if(!mBus->acquire(this)) {
+            return false;
+        }
+        auto isWrite = isWriteOperation(operation);
+        if(operation.processed < operation.size) {
+            selectSpeed(getChunkSize(operation));
+            auto status = beginTransfer(isWrite, getMemoryAddress(operation),
+                                        operation.bytes + operation.processed, getChunkSize(operation));
+            return startTransfer(operation, status, OperationStage_DataTransfer);
+        }
+        if(isWrite) {
+            operation.crc = calcCRC(operation.bytes, operation.size);
+        }
+        selectSpeed(sizeof(operation.crc));
+        auto status = beginTransfer(isWrite, 
+                                    getPageMemoryAddress(operation.page + getCountOfPagesFor(operation.size)),
+                                    reinterpret_cast<uint8_t*>(&operation.crc), sizeof(operation.crc));
+        return startTransfer(operation, status, OperationStage_CRCTransfer);
+    }
+
+    auto beginTransfer(bool isWrite, uint16_t memoryAddress, uint8_t* buffer, uint16_t size) const -> HAL_StatusTypeDef {
+        if(mConfig.transferMode == EEPROM_Transfer_DMA) {
+            auto start = isWrite ? HAL_I2C_Mem_Write_DMA : HAL_I2C_Mem_Read_DMA;
+            return start(mConfig.hI2C, mConfig.deviceAddress, memoryAddress, I2C_MEMADD_SIZE_16BIT, buffer, size);
+        }
+        auto start = isWrite ? HAL_I2C_Mem_Write_IT : HAL_I2C_Mem_Read_IT;
+        return start(mConfig.hI2C, mConfig.deviceAddress, memoryAddress, I2C_MEMADD_SIZE_16BIT, buffer, size);
+    }
+
+    auto startTransfer(EEPROM_Operation& operation, HAL_StatusTypeDef status, OperationStage stage) -> bool {
+        if(status == HAL_BUSY && isBusStuck()) {
+            auto isRecovered = recoverBus();
+            mBus->release(this);
+            return isRecovered ? false : complete(operation, EEPROM_Status_Error);
+        }
+        if(status != HAL_OK) {
+            mBus->release(this);
+        }
+        if(status == HAL_BUSY) {
+            // Peripheral is still used outside of the scheduler, retry on the next step
+            return false;
+        }
+        if(status != HAL_OK) {
+            return complete(operation, decodeStatusHAL(status));
+        }
+        operation.stage = stage;
+        operation.startTick = HAL_GetTick();
+        return false;
+    }
+
+    auto isTransferComplete(EEPROM_Operation& operation) -> bool {
+        auto isCRC = operation.stage == OperationStage_CRCTransfer;
+        auto size = isCRC ? static_cast<uint16_t>(sizeof(operation.crc)) : getChunkSize(operation);
+        if(HAL_I2C_GetState(mConfig.hI2C) != HAL_I2C_STATE_READY) {
+            if(HAL_GetTick() - operation.startTick > getTransferTimeout(size)) {
+                HAL_I2C_Master_Abort_IT(mConfig.hI2C, mConfig.deviceAddress);
+                if(isBusStuck()) {
+                    recoverBus();
+                }
+                mBus->release(this);
+                complete(operation, EEPROM_Status_Timeout);
+                return true;
+            }
+            return false;
+        }
+        mBus->release(this);
+        auto error = HAL_I2C_GetError(mConfig.hI2C);
+        auto status = error == HAL_I2C_ERROR_NONE ? HAL_OK : HAL_ERROR;
+        TRACE(isCRC ? EEPROM_TraceEvent_CRCTransfer : EEPROM_TraceEvent_PageTransfer, getMemoryAddress(operation), status);
+        if(recordTransfer(size, error)) {
+            // Same chunk again at the base timing on the next step
+            operation.stage = OperationStage_Queued;
+            return false;
+        }
+        if(status != HAL_OK) {
+            complete(operation, EEPROM_Status_Error);
+        }
+        return true;
+    }
+
+    auto startWriteCycle(EEPROM_Operation& operation, OperationStage stage) -> bool {
+        operation.stage = stage;
+        operation.startTick = HAL_GetTick();
+        return false;
+    }
+
+    // The chip does not acknowledge its address until the internal write cycle ends
+    auto isWriteCycleComplete(EEPROM_Operation& operation) -> bool {
+        if(!mBus->acquire(this)) {
+            return false;
+        }
+        auto status = HAL_I2C_IsDeviceReady(mConfig.hI2C, mConfig.deviceAddress, 1, 1);
+        mBus->release(this);
+        if(status == HAL_OK) {
+            TRACE(EEPROM_TraceEvent_WriteCycle, getMemoryAddress(operation), status);
+            return true;
+        }
+        if(HAL_GetTick() - operation.startTick > sWriteCycleTimeout) {
+            complete(operation, EEPROM_Status_Timeout);
+            return true;
+        }
+        return false;
+    }
+
+    auto complete(EEPROM_Operation& operation, EEPROM_Status status) -> bool {
+        TRACE(EEPROM_TraceEvent_OperationEnd, operation.page, status);
+        operation.status = status;
+        if(operation.onComplete != nullptr) {
+            operation.onComplete(&operation);
+        }
+        return true;
+    }
+
+    // A written chunk never crosses a page boundary, the chip would wrap around within
+    // the page. Reads roll over the whole array, they take one transfer.
+    auto getChunkSize(const EEPROM_Operation& operation) const -> uint16_t {
+        auto bytesRemain = operation.size - operation.processed;
+        if(!isWriteOperation(operation)) {
+            return bytesRemain;
+        }
+        auto pageRemain = mConfig.pageSize - getMemoryAddress(operation) % mConfig.pageSize;
+        return bytesRemain > pageRemain ? pageRemain : bytesRemain;
     }
-    
-private:    
 
     auto getPageMemoryAddress(uint16_t page) const -> uint16_t {
         return page * mConfig.pageSize;
     }
 
+    auto getMemoryAddress(const EEPROM_Operation& operation) const -> uint16_t {
+        return getPageMemoryAddress(operation.page) + operation.offset + operation.processed;
+    }
+
+    // Bulk timing for large transfers while the device allows it, short ones keep the current timing.
+    // A failed switch leaves the timing as it is, the statistics follow the actual one.
+    void selectSpeed(uint16_t size) {
+        if(!isBulkTimingActive()) {
+            mBus->setTiming(mBus->getBaseTiming());
+        } else if(size >= EEPROM_BULK_MIN_SIZE) {
+            mBus->setTiming(mConfig.bulkTiming);
+        }
+        auto isBulk = mConfig.bulkTiming != 0 && mConfig.hI2C->Init.Timing == mConfig.bulkTiming;
+        mSpeed = isBulk ? EEPROM_Speed_Bulk : EEPROM_Speed_Base;
+    }
+
+    // True if the error made the device fall back from the bulk timing, the transfer should be repeated
+    auto recordTransfer(uint16_t size, uint32_t error) -> bool {
+        auto& stats = mSpeedStats[mSpeed];
+        ++stats.transfers;
+        if(error == HAL_I2C_ERROR_NONE) {
+            stats.bytes += size;
+            mRecoveries = 0;
+            return false;
+        }
+        stats.nacks += (error & HAL_I2C_ERROR_AF) != 0;
+        stats.arbitrationLosses += (error & HAL_I2C_ERROR_ARLO) != 0;
+        if(mSpeed != EEPROM_Speed_Bulk || mIsBulkFailed || (error & (HAL_I2C_ERROR_AF | HAL_I2C_ERROR_ARLO)) == 0) {
+            return false;
+        }
+        ++stats.fallbacks;
+        mIsBulkFailed = true;
+        return true;
+    }
+
+    template<typename IO>
+    auto transferBlocking(IO inputOutputFunction, uint16_t memoryAddress, uint8_t* buffer, uint16_t size) {
+        auto isRecovered = false;
+        for(;;) {
+            selectSpeed(size);
+            auto status = inputOutputFunction(mConfig.hI2C, mConfig.deviceAddress, memoryAddress, I2C_MEMADD_SIZE_16BIT, 
+                                              buffer, size, getTransferTimeout(size));
+            if(status != HAL_OK && !isRecovered && isBusStuck()) {
+                // One recovery per transfer, a bus that sticks again fails the call
+                if(!recoverBus()) {
+                    return status;
+                }
+                isRecovered = true;
+                continue;
+            }
+            if(!recordTransfer(size, status == HAL_OK ? HAL_I2C_ERROR_NONE : HAL_I2C_GetError(mConfig.hI2C))) {
+                return status;
+            }
+        }
+    }
+
+    // Device address, two memory address bytes and the repeated device address of a read
+    auto getTransferTimeout(uint16_t size) const -> uint32_t {
+        if(mConfig.busSpeedHz == 0) {
+            return sTimeout;
+        }
+        auto bits = (size + 4u) * 9u;
+        auto milliseconds = (bits * 1000u + mConfig.busSpeedHz - 1) / mConfig.busSpeedHz;
+        return milliseconds * EEPROM_TIMEOUT_MARGIN_PERCENT / 100 + EEPROM_TIMEOUT_MIN_MS;
+    }
+
+    // Only valid while this device owns the bus and the peripheral should be idle
+    auto isBusStuck() const -> bool {
+        if(mConfig.sclPort == nullptr || mConfig.sdaPort == nullptr) {
+            return false;
+        }
+        return HAL_GPIO_ReadPin(mConfig.sdaPort, mConfig.sdaPin) == GPIO_PIN_RESET || 
+               HAL_GPIO_ReadPin(mConfig.sclPort, mConfig.sclPin) == GPIO_PIN_RESET;
+    }
+
+    // A slave interrupted in the middle of a byte holds SDA until it clocked out the rest of it
+    auto recoverBus() -> bool {
+        if(mRecoveries >= EEPROM_BUS_RECOVERY_LIMIT) {
+            return false;
+        }
+        ++mRecoveries;
+        ++mRecoveriesTotal;
+        HAL_I2C_DeInit(mConfig.hI2C);
+        GPIO_InitTypeDef pins{};
+        pins.Mode = GPIO_MODE_OUTPUT_OD;
+        pins.Pull = GPIO_NOPULL;
+        pins.Speed = GPIO_SPEED_FREQ_LOW;
+        HAL_GPIO_WritePin(mConfig.sclPort, mConfig.sclPin, GPIO_PIN_SET);
+        HAL_GPIO_WritePin(mConfig.sdaPort, mConfig.sdaPin, GPIO_PIN_SET);
+        pins.Pin = mConfig.sclPin;
+        HAL_GPIO_Init(mConfig.sclPort, &pins);
+        pins.Pin = mConfig.sdaPin;
+        HAL_GPIO_Init(mConfig.sdaPort, &pins);
+        for(auto clock = 0; clock < 9 && HAL_GPIO_ReadPin(mConfig.sdaPort, mConfig.sdaPin) == GPIO_PIN_RESET; ++clock) {
+            HAL_GPIO_WritePin(mConfig.sclPort, mConfig.sclPin, GPIO_PIN_RESET);
+            waitHalfBit();
+            HAL_GPIO_WritePin(mConfig.sclPort, mConfig.sclPin, GPIO_PIN_SET);
+            waitHalfBit();
+        }
+        // STOP: SDA rises while SCL is high
+        HAL_GPIO_WritePin(mConfig.sclPort, mConfig.sclPin, GPIO_PIN_RESET);
+        waitHalfBit();
+        HAL_GPIO_WritePin(mConfig.sdaPort, mConfig.sdaPin, GPIO_PIN_RESET);
+        waitHalfBit();
+        HAL_GPIO_WritePin(mConfig.sclPort, mConfig.sclPin, GPIO_PIN_SET);
+        waitHalfBit();
+        HAL_GPIO_WritePin(mConfig.sdaPort, mConfig.sdaPin, GPIO_PIN_SET);
+        waitHalfBit();
+        auto isReleased = !isBusStuck();
+        // The MSP init gives the pins back to the peripheral
+        auto status = HAL_I2C_Init(mConfig.hI2C);
+        TRACE(EEPROM_TraceEvent_BusRecovery, 0, isReleased);
+        return isReleased && status == HAL_OK;
+    }
+
+    // Slaves accept any clock down to DC, the loop only has to be slow enough for the slowest one
+    static void waitHalfBit() {
+        volatile uint32_t count = 0;
+        while(count < SystemCoreClock / 1000000) {
+            count = count + 1;
+        }
+    }
+
     template<typename IO>
-    auto iterateOverPages(int16_t page, uint8_t* buffer, size_t size, IO inputOutputFunction, uint16_t delay) const {
+    auto iterateOverPages(int16_t page, uint8_t* buffer, size_t size, IO inputOutputFunction, uint16_t delay) {
         auto memoryAddress = getPageMemoryAddress(page);
         auto ptr = buffer;
         for(uint16_t bytesRemain = size; bytesRemain > 0;) {
             auto countOfBytesToProcess = bytesRemain > mConfig.pageSize ? mConfig.pageSize : bytesRemain;
-            auto status = inputOutputFunction(mConfig.hI2C, 
-                          mConfig.deviceAddress, 
-                          memoryAddress, I2C_MEMADD_SIZE_16BIT, 
-                          ptr, countOfBytesToProcess, 
-                          sTimeout); 
+            auto status = transferBlocking(inputOutputFunction, memoryAddress, ptr, countOfBytesToProcess); 
+            TRACE(EEPROM_TraceEvent_PageTransfer, memoryAddress, status);
             if(status != HAL_OK) {
                 return status;
             }
-            HAL_Delay(delay);            
+            waitFor(delay);            
+            if(delay != 0) {
+                TRACE(EEPROM_TraceEvent_WriteCycle, memoryAddress, HAL_OK);
+            }
             bytesRemain -= countOfBytesToProcess;
             memoryAddress += mConfig.pageSize;
             ptr += mConfig.pageSize;
@@ -99,57 +731,524 @@ private:
         return HAL_OK;
     }
 
-    auto writeBuffer(uint16_t page, uint8_t* buffer, size_t size) const -> HAL_StatusTypeDef {
+    auto writeBuffer(uint16_t page, uint8_t* buffer, size_t size) -> HAL_StatusTypeDef {
         return iterateOverPages(page, buffer, size, HAL_I2C_Mem_Write, sWriteDelay);
     }
 
-    auto writeCRC(uint16_t page, uint8_t* buffer, size_t bufferSize) const -> HAL_StatusTypeDef {
+    auto writeCRC(uint16_t page, uint8_t* buffer, size_t bufferSize) -> HAL_StatusTypeDef {
         auto crc = calcCRC(buffer, bufferSize);                
-        return HAL_I2C_Mem_Write(mConfig.hI2C, mConfig.deviceAddress, 
-            getPageMemoryAddress(page),            
-            I2C_MEMADD_SIZE_16BIT, 
-            reinterpret_cast<uint8_t*>(&crc), sizeof(crc), 
-            sTimeout);
+        auto status = transferBlocking(HAL_I2C_Mem_Write, getPageMemoryAddress(page), 
+                                       reinterpret_cast<uint8_t*>(&crc), sizeof(crc));
+        TRACE(EEPROM_TraceEvent_CRCTransfer, getPageMemoryAddress(page), status);
+        if(status == HAL_OK) {
+            // The next call would be NACKed while the CRC page is programmed
+            waitFor(sWriteDelay);
+            TRACE(EEPROM_TraceEvent_WriteCycle, getPageMemoryAddress(page), HAL_OK);
+        }
+        return status;
     }
 
-    auto readBuffer(uint16_t page, uint8_t* buffer, size_t size) const -> HAL_StatusTypeDef {
+    // Any address, reads aren't split
+    auto readBytes(uint16_t memoryAddress, uint8_t* buffer, uint16_t size) -> HAL_StatusTypeDef {
+        auto status = transferBlocking(HAL_I2C_Mem_Read, memoryAddress, buffer, size);
+        TRACE(EEPROM_TraceEvent_PageTransfer, memoryAddress, status);
+        return status;
+    }
+
+    // Any address, split at the page boundaries
+    auto writeBytes(uint16_t memoryAddress, uint8_t* buffer, uint16_t size) -> HAL_StatusTypeDef {
+        while(size > 0) {
+            auto pageRemain = static_cast<uint16_t>(mConfig.pageSize - memoryAddress % mConfig.pageSize);
+            auto countOfBytesToProcess = size > pageRemain ? pageRemain : size;
+            auto status = transferBlocking(HAL_I2C_Mem_Write, memoryAddress, buffer, countOfBytesToProcess);
+            TRACE(EEPROM_TraceEvent_PageTransfer, memoryAddress, status);
+            if(status != HAL_OK) {
+                return status;
+            }
+            waitFor(sWriteDelay);
+            TRACE(EEPROM_TraceEvent_WriteCycle, memoryAddress, HAL_OK);
+            memoryAddress += countOfBytesToProcess;
+            buffer += countOfBytesToProcess;
+            size -= countOfBytesToProcess;
+        }
+        return HAL_OK;
+    }
+
+    auto readBuffer(uint16_t page, uint8_t* buffer, size_t size) -> HAL_StatusTypeDef {
         return iterateOverPages(page, buffer, size, HAL_I2C_Mem_Read, 0);    
     }
 
-    auto readCRC(uint16_t page, uint32_t& crc) const -> HAL_StatusTypeDef {                
-        return HAL_I2C_Mem_Read(mConfig.hI2C, mConfig.deviceAddress, 
-            getPageMemoryAddress(page), 
-            I2C_MEMADD_SIZE_16BIT, 
-            reinterpret_cast<uint8_t*>(&crc), sizeof(crc), 
-            sTimeout);
+    auto readCRC(uint16_t page, uint32_t& crc) -> HAL_StatusTypeDef {                
+        auto status = transferBlocking(HAL_I2C_Mem_Read, getPageMemoryAddress(page), 
+                                       reinterpret_cast<uint8_t*>(&crc), sizeof(crc));
+        TRACE(EEPROM_TraceEvent_CRCTransfer, getPageMemoryAddress(page), status);
+        return status;
     }       
 
+    // Chip select bits of the address tell the chips on one bus apart in the trace
+    auto getTraceInfo(uint8_t code) const -> uint8_t {
+        return static_cast<uint8_t>(((mConfig.deviceAddress >> 1) & 0x07) << 5 | (code & 0x1F));
+    }
+
     auto calcCRC(uint8_t* buffer, uint16_t bufferSize) const -> uint32_t {
         return HAL_CRC_Calculate(mConfig.hCRC,  reinterpret_cast<uint32_t*>(buffer), bufferSize / 4);
     }
     
-    EEPROM_Config mConfig{nullptr, nullptr, 0xA0, 64};    
+    EEPROM_Config mConfig{nullptr, nullptr, 0xA0, 64, EEPROM_Transfer_IT, 0, 0, nullptr, nullptr, 0, 0};    
+    EEPROM_Operation* mHead{};
+    EEPROM_Operation* mTail{};
+    Bus* mBus{};
+    EEPROM_SpeedStats mSpeedStats[EEPROM_Speed_Count]{};
+    EEPROM_Speed mSpeed{EEPROM_Speed_Base};
+    bool mIsBulkFailed{};
+    uint8_t mRecoveries{};
+    uint32_t mRecoveriesTotal{};
 }; 
 
-static auto sInstance = EEPROM{};
+void Bus::step() {
+    if(mCount == 0) {
+        return;
+    }
+    // Rotate the first device so a chip with a long queue can't starve the others
+    auto first = mNext++ % mCount;
+    for(uint8_t i = 0; i < mCount; ++i) {
+        mDevices[(first + i) % mCount]->step();
+    }
+}
+
+static EEPROM sDevices[EEPROM_MAX_DEVICES];
+static Bus sBuses[EEPROM_MAX_DEVICES];
+static auto& sInstance = sDevices[0];
+static EEPROM_BackgroundTask* sBackgroundTasks{};
+static EEPROM_WriteObserver* sWriteObservers{};
+
+static void notifyWritten(const EEPROM* device, uint16_t page, uint16_t lastPage) {
+    auto index = static_cast<uint8_t>(device - sDevices);
+    for(auto observer = sWriteObservers; observer != nullptr; observer = observer->next) {
+        observer->onWrite(observer->context, index, page, lastPage);
+    }
+}
+
+// Integrity of the plain blocking calls for a record, EEPROM_Integrity_Full if it has none
+struct RecordIntegrity {
+    uint16_t page;
+    uint16_t size;
+    uint8_t device;
+    uint8_t integrity;
+    bool isUsed;
+};
+
+static RecordIntegrity sRecordIntegrities[EEPROM_RECORD_POLICIES];
+
+static auto findRecordIntegrity(uint8_t device, uint16_t page) -> RecordIntegrity* {
+    for(auto& record : sRecordIntegrities) {
+        if(record.isUsed && record.device == device && record.page == page) {
+            return &record;
+        }
+    }
+    return nullptr;
+}
+
+static auto getRecordIntegrity(uint8_t device, uint16_t page, uint16_t size) -> uint8_t {
+    auto record = findRecordIntegrity(device, page);
+    if(record == nullptr || record->size != size) {
+        return EEPROM_Integrity_Full;
+    }
+    return record->integrity;
+}
+
+static auto attachToBus(EEPROM& device) {
+    auto handle = device.getConfig().hI2C;
+    if(auto bus = device.getBus(); bus != nullptr) {
+        if(bus->getHandle() == handle) {
+            return EEPROM_Status_Sucess;
+        }
+        bus->detach(&device);
+        device.setBus(nullptr);
+    }
+    Bus* freeBus = nullptr;
+    for(auto& bus : sBuses) {
+        if(bus.getHandle() == handle) {
+            freeBus = &bus;
+            break;
+        }
+        if(freeBus == nullptr && bus.getHandle() == nullptr) {
+            freeBus = &bus;
+        }
+    }
+    if(freeBus == nullptr || !freeBus->attach(handle, &device)) {
+        return EEPROM_Status_Error;
+    }
+    device.setBus(freeBus);
+    return EEPROM_Status_Sucess;
+}
+
+static auto submitGroup(EEPROM_Operation* operations, const uint8_t* devices, uint8_t count) {
+    if(count == 0) {
+        return EEPROM_Status_Error;
+    }
+    for(uint8_t i = 0; i < count; ++i) {
+        if(devices[i] >= EEPROM_MAX_DEVICES || !sDevices[devices[i]].isInitialized()) {
+            return EEPROM_Status_NotInitialized;
+        }
+        if(operations[i].status == EEPROM_Status_Pending) {
+            return EEPROM_Status_Busy;
+        }
+    }
+    return EEPROM_Status_Sucess;
+}
+
+static auto submitSplit(EEPROM_Operation* operations, const uint8_t* devices, uint8_t count, 
+                        OperationType type, uint16_t page, uint8_t* bytes, uint16_t size) {
+    if(auto status = submitGroup(operations, devices, count); status != EEPROM_Status_Sucess) {
+        return status;
+    }
+    auto partSize = EEPROM_getSplitPartSize(size, count);
+    uint16_t offset = 0;
+    for(uint8_t i = 0; i < count; ++i) {
+        auto remain = static_cast<uint16_t>(size - offset);
+        auto currentSize = remain > partSize ? partSize : remain;
+        auto status = sDevices[devices[i]].submit(operations[i], type, page, bytes + offset, currentSize);
+        if(status != EEPROM_Status_Sucess) {
+            return status;
+        }
+        offset += currentSize;
+    }
+    return EEPROM_Status_Sucess;
+}
+
+static auto initDevice(EEPROM& device, const EEPROM_Config& config) {
+    if(!device.isIdle()) {
+        return EEPROM_Status_Busy;
+    }
+    if(auto status = device.init(config); status != EEPROM_Status_Sucess) {
+        return status;
+    }
+    forgetVerified(&device, 0, UINT16_MAX);
+    return attachToBus(device);
+}
 
 EEPROM_Config EEPROM_makeDefaultConfig(I2C_HandleTypeDef* hI2C, CRC_HandleTypeDef* hCRC) {
-    return EEPROM_Config{ hI2C, hCRC, 0xA0, 64};
+    // Timeouts for Standard-mode hold for any faster clock
+    return EEPROM_Config{ hI2C, hCRC, 0xA0, 64, EEPROM_Transfer_IT, 0, 100000, nullptr, nullptr, 0, 0};
 }
 
 EEPROM_Status EEPROM_Init(EEPROM_Config config) {        
-    return sInstance.init(config);    
+    return initDevice(sInstance, config);    
 }
 
 EEPROM_Status EEPROM_Read(uint16_t page, uint8_t* bytes, uint16_t size) {   
-    return sInstance.read(page, bytes, size, true);    
+    return EEPROM_ReadDevice(0, page, bytes, size);
 }
 
 EEPROM_Status EEPROM_Write(uint16_t page, uint8_t* bytes, uint16_t size) {           
-    return sInstance.write(page, bytes, size, true);    
+    return EEPROM_WriteDevice(0, page, bytes, size);
+}
+
+EEPROM_Status EEPROM_ReadEx(uint16_t page, uint8_t* bytes, uint16_t size, uint8_t integrity) {
+    return EEPROM_ReadDeviceEx(0, page, bytes, size, integrity);
+}
+
+EEPROM_Status EEPROM_WriteEx(uint16_t page, uint8_t* bytes, uint16_t size, uint8_t integrity) {
+    return EEPROM_WriteDeviceEx(0, page, bytes, size, integrity);
 }
 
 uint16_t EEPROM_getBuffersPagesCount(uint16_t bufferSize) {
     // + 1 - page for CRC
     return sInstance.getCountOfPagesFor(bufferSize) + 1;
 }
+
+EEPROM_Status EEPROM_ReadAsync(EEPROM_Operation* operation, uint16_t page, uint8_t* bytes, uint16_t size) {
+    return sInstance.submit(*operation, OperationType_Read, page, bytes, size);
+}
+
+EEPROM_Status EEPROM_WriteAsync(EEPROM_Operation* operation, uint16_t page, uint8_t* bytes, uint16_t size) {
+    return sInstance.submit(*operation, OperationType_Write, page, bytes, size);
+}
+
+EEPROM_Status EEPROM_getOperationStatus(const EEPROM_Operation* operation) {
+    return operation->status;
+}
+
+uint8_t EEPROM_isIdle(void) {
+    for(auto& device : sDevices) {
+        if(!device.isIdle()) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+void EEPROM_Step(void) {
+    for(auto& bus : sBuses) {
+        bus.step();
+    }
+    for(auto task = sBackgroundTasks; task != nullptr; task = task->next) {
+        task->run(task->context);
+    }
+}
+
+void EEPROM_setSleepOnWait(uint8_t enable) {
+    sSleepOnWait = enable != 0;
+}
+
+void EEPROM_addBackgroundTask(EEPROM_BackgroundTask* task) {
+    for(auto current = sBackgroundTasks; current != nullptr; current = current->next) {
+        if(current == task) {
+            return;
+        }
+    }
+    task->next = sBackgroundTasks;
+    sBackgroundTasks = task;
+}
+
+void EEPROM_addWriteObserver(EEPROM_WriteObserver* observer) {
+    for(auto current = sWriteObservers; current != nullptr; current = current->next) {
+        if(current == observer) {
+            return;
+        }
+    }
+    observer->next = sWriteObservers;
+    sWriteObservers = observer;
+}
+
+EEPROM_Status EEPROM_InitDevice(uint8_t device, EEPROM_Config config) {
+    if(device >= EEPROM_MAX_DEVICES) {
+        return EEPROM_Status_NotInitialized;
+    }
+    return initDevice(sDevices[device], config);
+}
+
+EEPROM_Status EEPROM_ReadDevice(uint8_t device, uint16_t page, uint8_t* bytes, uint16_t size) {
+    if(device >= EEPROM_MAX_DEVICES) {
+        return EEPROM_Status_NotInitialized;
+    }
+    return EEPROM_ReadDeviceEx(device, page, bytes, size, getRecordIntegrity(device, page, size));
+}
+
+EEPROM_Status EEPROM_WriteDevice(uint8_t device, uint16_t page, uint8_t* bytes, uint16_t size) {
+    if(device >= EEPROM_MAX_DEVICES) {
+        return EEPROM_Status_NotInitialized;
+    }
+    return EEPROM_WriteDeviceEx(device, page, bytes, size, getRecordIntegrity(device, page, size));
+}
+
+EEPROM_Status EEPROM_setRecordIntegrity(uint8_t device, uint16_t page, uint16_t size, uint8_t integrity) {
+    if(device >= EEPROM_MAX_DEVICES || integrity > EEPROM_Integrity_Full) {
+        return EEPROM_Status_Error;
+    }
+    auto record = findRecordIntegrity(device, page);
+    for(auto& free : sRecordIntegrities) {
+        if(record == nullptr && !free.isUsed) {
+            record = &free;
+        }
+    }
+    if(record == nullptr) {
+        return EEPROM_Status_Error;
+    }
+    *record = RecordIntegrity{page, size, device, integrity, integrity != EEPROM_Integrity_Full};
+    return EEPROM_Status_Sucess;
+}
+
+EEPROM_Status EEPROM_ReadDeviceEx(uint8_t device, uint16_t page, uint8_t* bytes, uint16_t size, uint8_t integrity) {
+    if(device >= EEPROM_MAX_DEVICES) {
+        return EEPROM_Status_NotInitialized;
+    }
+    auto& eeprom = sDevices[device];
+    auto verified = findVerified(&eeprom, page);
+    auto isTrusted = integrity == EEPROM_Integrity_Lazy && verified != nullptr && verified->size == size;
+    if(integrity == EEPROM_Integrity_Raw || integrity == EEPROM_Integrity_CRCOnWrite || isTrusted) {
+        return eeprom.read(page, bytes, size, false);
+    }
+    auto status = eeprom.read(page, bytes, size, true);
+    if(integrity == EEPROM_Integrity_Lazy && status == EEPROM_Status_Sucess) {
+        markVerified(&eeprom, page, eeprom.getCRCPage(page, size), size);
+    }
+    return status;
+}
+
+EEPROM_Status EEPROM_WriteDeviceEx(uint8_t device, uint16_t page, uint8_t* bytes, uint16_t size, uint8_t integrity) {
+    if(device >= EEPROM_MAX_DEVICES) {
+        return EEPROM_Status_NotInitialized;
+    }
+    auto& eeprom = sDevices[device];
+    auto status = eeprom.write(page, bytes, size, integrity != EEPROM_Integrity_Raw);
+    // Written together with its CRC, so it matches as long as the write succeeded
+    if(integrity == EEPROM_Integrity_Lazy && status == EEPROM_Status_Sucess) {
+        markVerified(&eeprom, page, eeprom.getCRCPage(page, size), size);
+    }
+    return status;
+}
+
+EEPROM_Status EEPROM_ReadDeviceAsync(uint8_t device, EEPROM_Operation* operation, uint16_t page, uint8_t* bytes, uint16_t size) {
+    if(device >= EEPROM_MAX_DEVICES) {
+        return EEPROM_Status_NotInitialized;
+    }
+    return sDevices[device].submit(*operation, OperationType_Read, page, bytes, size);
+}
+
+EEPROM_Status EEPROM_WriteDeviceAsync(uint8_t device, EEPROM_Operation* operation, uint16_t page, uint8_t* bytes, uint16_t size) {
+    if(device >= EEPROM_MAX_DEVICES) {
+        return EEPROM_Status_NotInitialized;
+    }
+    return sDevices[device].submit(*operation, OperationType_Write, page, bytes, size);
+}
+
+EEPROM_Status EEPROM_ReadDeviceRawAsync(uint8_t device, EEPROM_Operation* operation, uint16_t page, uint8_t* bytes, uint16_t size) {
+    if(device >= EEPROM_MAX_DEVICES) {
+        return EEPROM_Status_NotInitialized;
+    }
+    return sDevices[device].submit(*operation, OperationType_ReadRaw, page, bytes, size);
+}
+
+EEPROM_Status EEPROM_WriteDeviceRawAsync(uint8_t device, EEPROM_Operation* operation, uint16_t page, uint8_t* bytes, uint16_t size) {
+    if(device >= EEPROM_MAX_DEVICES) {
+        return EEPROM_Status_NotInitialized;
+    }
+    return sDevices[device].submit(*operation, OperationType_WriteRaw, page, bytes, size);
+}
+
+EEPROM_Status EEPROM_ReadDeviceBytesAsync(uint8_t device, EEPROM_Operation* operation, uint16_t address, uint8_t* bytes, uint16_t size) {
+    if(device >= EEPROM_MAX_DEVICES || !sDevices[device].isInitialized()) {
+        return EEPROM_Status_NotInitialized;
+    }
+    auto pageSize = sDevices[device].getConfig().pageSize;
+    return sDevices[device].submit(*operation, OperationType_ReadRaw, address / pageSize, bytes, size, address % pageSize);
+}
+
+EEPROM_Status EEPROM_WriteDeviceBytesAsync(uint8_t device, EEPROM_Operation* operation, uint16_t address, uint8_t* bytes, uint16_t size) {
+    if(device >= EEPROM_MAX_DEVICES || !sDevices[device].isInitialized()) {
+        return EEPROM_Status_NotInitialized;
+    }
+    auto pageSize = sDevices[device].getConfig().pageSize;
+    return sDevices[device].submit(*operation, OperationType_WriteRaw, address / pageSize, bytes, size, address % pageSize);
+}
+
+uint8_t EEPROM_isDeviceIdle(uint8_t device) {
+    return device < EEPROM_MAX_DEVICES && sDevices[device].isIdle();
+}
+
+EEPROM_Status EEPROM_getSpeedStats(uint8_t device, uint8_t speed, EEPROM_SpeedStats* stats) {
+    if(device >= EEPROM_MAX_DEVICES || !sDevices[device].isInitialized()) {
+        return EEPROM_Status_NotInitialized;
+    }
+    if(speed >= EEPROM_Speed_Count) {
+        return EEPROM_Status_Error;
+    }
+    *stats = sDevices[device].getSpeedStats(speed);
+    return EEPROM_Status_Sucess;
+}
+
+uint8_t EEPROM_isBulkTimingActive(uint8_t device) {
+    return device < EEPROM_MAX_DEVICES && sDevices[device].isBulkTimingActive();
+}
+
+uint32_t EEPROM_getBusRecoveries(uint8_t device) {
+    return device < EEPROM_MAX_DEVICES ? sDevices[device].getBusRecoveries() : 0;
+}
+
+uint16_t EEPROM_getDevicePageSize(uint8_t device) {
+    if(device >= EEPROM_MAX_DEVICES || !sDevices[device].isInitialized()) {
+        return 0;
+    }
+    return sDevices[device].getConfig().pageSize;
+}
+
+EEPROM_Status EEPROM_MirrorWriteAsync(EEPROM_Operation* operations, const uint8_t* devices, uint8_t count, uint16_t page, uint8_t* bytes, uint16_t size) {
+    if(auto status = submitGroup(operations, devices, count); status != EEPROM_Status_Sucess) {
+        return status;
+    }
+    for(uint8_t i = 0; i < count; ++i) {
+        auto status = sDevices[devices[i]].submit(operations[i], OperationType_Write, page, bytes, size);
+        if(status != EEPROM_Status_Sucess) {
+            return status;
+        }
+    }
+    return EEPROM_Status_Sucess;
+}
+
+EEPROM_Status EEPROM_SplitWriteAsync(EEPROM_Operation* operations, const uint8_t* devices, uint8_t count, uint16_t page, uint8_t* bytes, uint16_t size) {
+    return submitSplit(operations, devices, count, OperationType_Write, page, bytes, size);
+}
+
+EEPROM_Status EEPROM_SplitReadAsync(EEPROM_Operation* operations, const uint8_t* devices, uint8_t count, uint16_t page, uint8_t* bytes, uint16_t size) {
+    return submitSplit(operations, devices, count, OperationType_Read, page, bytes, size);
+}
+
+EEPROM_Status EEPROM_getGroupStatus(const EEPROM_Operation* operations, uint8_t count) {
+    auto result = EEPROM_Status_Sucess;
+    for(uint8_t i = 0; i < count; ++i) {
+        if(operations[i].status == EEPROM_Status_Pending) {
+            return EEPROM_Status_Pending;
+        }
+        if(result == EEPROM_Status_Sucess) {
+            result = operations[i].status;
+        }
+    }
+    return result;
+}
+
+uint16_t EEPROM_getSplitPartSize(uint16_t size, uint8_t count) {
+    if(count == 0) {
+        return size;
+    }
+    // Parts are word aligned, the CRC unit works with 32-bit words
+    auto partSize = (size + count - 1) / count;
+    return static_cast<uint16_t>((partSize + 3) & ~3);
+}
+
+// Polynomials over GF(2) modulo the CRC-32 polynomial, bit 31 is x^31
+static auto multiplyModulo(uint32_t left, uint32_t right) -> uint32_t {
+    uint32_t product = 0;
+    for(auto bit = 31; bit >= 0; --bit) {
+        product = (product & 0x80000000U) ? (product << 1) ^ 0x04C11DB7U : product << 1;
+        if(right & (1U << bit)) {
+            product ^= left;
+        }
+    }
+    return product;
+}
+
+// x^(32 * words): the effect of running the CRC register over that many zero words
+static auto shiftByWords(uint32_t words) -> uint32_t {
+    uint32_t result = 1;
+    // x^32 modulo the polynomial
+    uint32_t square = 0x04C11DB7U;
+    for(; words != 0; words >>= 1) {
+        if(words & 1) {
+            result = multiplyModulo(result, square);
+        }
+        square = multiplyModulo(square, square);
+    }
+    return result;
+}
+
+uint32_t EEPROM_patchCRC(CRC_HandleTypeDef* hCRC, uint32_t crc, uint16_t recordSize, uint16_t offset, 
+                         const uint8_t* oldBytes, const uint8_t* newBytes, uint16_t size) {
+    // Whole words around the range, the CRC unit reads them like the record
+    uint32_t difference[EEPROM_PATCH_MAX_SIZE / 4 + 2]{};
+    auto start = offset & ~3U;
+    auto end = (offset + size + 3U) & ~3U;
+    auto words = (end - start) / 4;
+    auto bytes = reinterpret_cast<uint8_t*>(difference);
+    for(uint16_t i = 0; i < size; ++i) {
+        bytes[offset - start + i] = oldBytes[i] ^ newBytes[i];
+    }
+    // The unit starts from 0xFFFFFFFF, its share is taken out to get the CRC from 0
+    auto patch = HAL_CRC_Calculate(hCRC, difference, words) ^ multiplyModulo(0xFFFFFFFFU, shiftByWords(words));
+    return crc ^ multiplyModulo(patch, shiftByWords(recordSize / 4 - end / 4));
+}
+
+EEPROM_Status EEPROM_PatchDevice(uint8_t device, uint16_t page, uint16_t recordSize, uint16_t offset, const uint8_t* bytes, uint16_t size) {
+    if(device >= EEPROM_MAX_DEVICES) {
+        return EEPROM_Status_NotInitialized;
+    }
+    if(size == 0 || size > EEPROM_PATCH_MAX_SIZE || recordSize % 4 != 0 || offset + size > recordSize) {
+        return EEPROM_Status_Error;
+    }
+    return sDevices[device].patch(page, recordSize, offset, bytes, size);
+}
+
+EEPROM_Status EEPROM_Patch(uint16_t page, uint16_t recordSize, uint16_t offset, const uint8_t* bytes, uint16_t size) {
+    return EEPROM_PatchDevice(0, page, recordSize, offset, bytes, size);
+}
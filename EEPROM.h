@@ -1,3 +1,4 @@
+#pragma once
 #include "main.h"
 #include <stdint.h>
 
@@ -5,28 +6,222 @@
 extern "C" {
 #endif
 
+// Chips with different device addresses may share one I2C handle,
+// EEPROM_Step() interleaves their transfers while the others are in a write cycle.
+#ifndef EEPROM_MAX_DEVICES
+#define EEPROM_MAX_DEVICES 4
+#endif
+
+// Transfers of at least this many bytes switch the bus to EEPROM_Config::bulkTiming,
+// shorter ones (CRC words) run at whatever timing the bus has
+#ifndef EEPROM_BULK_MIN_SIZE
+#define EEPROM_BULK_MIN_SIZE 16
+#endif
+
+// Transfer timeouts are the time on the wire at EEPROM_Config::busSpeedHz
+// times the margin, plus the minimum covering the granularity of the tick
+#ifndef EEPROM_TIMEOUT_MARGIN_PERCENT
+#define EEPROM_TIMEOUT_MARGIN_PERCENT 200
+#endif
+
+#ifndef EEPROM_TIMEOUT_MIN_MS
+#define EEPROM_TIMEOUT_MIN_MS 2
+#endif
+
+// Largest range changed by one EEPROM_Patch()
+#ifndef EEPROM_PATCH_MAX_SIZE
+#define EEPROM_PATCH_MAX_SIZE 32
+#endif
+
+// Records remembered as verified by EEPROM_Integrity_Lazy reads
+#ifndef EEPROM_VERIFIED_RECORDS
+#define EEPROM_VERIFIED_RECORDS 8
+#endif
+
+// Records with an integrity of their own, see EEPROM_setRecordIntegrity()
+#ifndef EEPROM_RECORD_POLICIES
+#define EEPROM_RECORD_POLICIES 8
+#endif
+
+// Bus recoveries without a successful transfer in between before operations fail right away
+#ifndef EEPROM_BUS_RECOVERY_LIMIT
+#define EEPROM_BUS_RECOVERY_LIMIT 3
+#endif
+
 typedef enum {
   EEPROM_Status_Sucess,    
   EEPROM_Status_NotInitialized,
   EEPROM_Status_Busy,
   EEPROM_Status_Timeout,
   EEPROM_Status_InvalidCRC,  
-  EEPROM_Status_Error
+  EEPROM_Status_Error,
+  EEPROM_Status_Pending
 } EEPROM_Status;
 
+typedef enum {
+  EEPROM_Transfer_IT,
+  EEPROM_Transfer_DMA
+} EEPROM_TransferMode;
+
 typedef struct {
   I2C_HandleTypeDef* hI2C;
   CRC_HandleTypeDef* hCRC;
   uint16_t deviceAddress;
   uint16_t pageSize;
+  // How EEPROM_Step() drives page transfers, DMA requires the I2C DMA streams to be linked
+  uint8_t transferMode;
+  // Optional I2C_TIMINGR value for bulk transfers, e.g. Fast-mode Plus if the chip supports it.
+  // The handle is re-initialized while the bus is idle. A NACK or an arbitration loss at this
+  // timing falls back to the handle's own timing until the next init. 0 disables it.
+  uint32_t bulkTiming;
+  // Slowest clock of the bus, the transfer timeouts are derived from it. 0 keeps a fixed 50 ms.
+  uint32_t busSpeedHz;
+  // Optional pins of the bus. When the peripheral reports a busy bus or a transfer times out
+  // with SDA held low, the pins are clocked as GPIO until the slave releases SDA (at most
+  // 9 clocks), a STOP is generated and the peripheral is re-initialized. Null ports disable it.
+  GPIO_TypeDef* sclPort;
+  GPIO_TypeDef* sdaPort;
+  uint16_t sclPin;
+  uint16_t sdaPin;
 } EEPROM_Config;
 
+// How EEPROM_ReadEx()/EEPROM_WriteEx() treat the CRC page of a record
+typedef enum {
+  // Payload only, no CRC page is read or written
+  EEPROM_Integrity_Raw,
+  // Writes store the CRC, reads transfer the payload only
+  EEPROM_Integrity_CRCOnWrite,
+  // The first read since boot is checked, later reads of the record transfer the payload only
+  EEPROM_Integrity_Lazy,
+  // Every read is checked, like EEPROM_Read()
+  EEPROM_Integrity_Full
+} EEPROM_Integrity;
+
+typedef enum {
+  EEPROM_Speed_Base,
+  EEPROM_Speed_Bulk,
+  EEPROM_Speed_Count
+} EEPROM_Speed;
+
+// Data and CRC transfers of one device at one timing, write cycle polls are not counted
+typedef struct {
+  uint32_t transfers;
+  uint32_t bytes;
+  uint32_t nacks;
+  uint32_t arbitrationLosses;
+  uint32_t fallbacks;
+} EEPROM_SpeedStats;
+
+// Non-blocking operation, zero-initialize it before the first use. The structure
+// and the buffer must stay valid until EEPROM_getOperationStatus() stops
+// returning EEPROM_Status_Pending.
+// Transfers use the I2C interrupt or DMA mode, so the I2C event/error IRQs must be enabled.
+typedef struct EEPROM_Operation {
+  struct EEPROM_Operation* next;
+  uint8_t* bytes;
+  uint32_t crc;
+  uint32_t startTick;
+  uint16_t page;
+  // Byte offset into the first page, raw byte operations only
+  uint16_t offset;
+  uint16_t size;
+  uint16_t processed;
+  uint8_t type;
+  uint8_t stage;
+  volatile EEPROM_Status status;
+  // Optional, called by EEPROM_Step() once the status is final. Must not submit operations or block.
+  void (*onComplete)(struct EEPROM_Operation* operation);
+  void* context;
+} EEPROM_Operation;
+
+// Hook executed by EEPROM_Step() after the queues were advanced, used by
+// modules that do background work on top of the driver. Must not block.
+typedef struct EEPROM_BackgroundTask {
+  void (*run)(void* context);
+  void* context;
+  struct EEPROM_BackgroundTask* next;
+} EEPROM_BackgroundTask;
+
+// Hook called by every write of the driver as it starts, with the pages it touches. Used by
+// modules that keep copies of the device contents. Must not block or submit operations.
+typedef struct EEPROM_WriteObserver {
+  void (*onWrite)(void* context, uint8_t device, uint16_t page, uint16_t lastPage);
+  void* context;
+  struct EEPROM_WriteObserver* next;
+} EEPROM_WriteObserver;
+
 EEPROM_Config EEPROM_makeDefaultConfig(I2C_HandleTypeDef* hI2C, CRC_HandleTypeDef* hCRC);
 EEPROM_Status EEPROM_Init(EEPROM_Config config);
 EEPROM_Status EEPROM_Read(uint16_t page, uint8_t* bytes, uint16_t size);
 EEPROM_Status EEPROM_Write(uint16_t page, uint8_t* bytes, uint16_t size);
+// Blocking calls with an EEPROM_Integrity for this call only. A lazily verified record stays
+// trusted until any write of the driver touches its pages or the device is initialized again.
+EEPROM_Status EEPROM_ReadEx(uint16_t page, uint8_t* bytes, uint16_t size, uint8_t integrity);
+EEPROM_Status EEPROM_WriteEx(uint16_t page, uint8_t* bytes, uint16_t size, uint8_t integrity);
 uint16_t EEPROM_getBuffersPagesCount(uint16_t bufferSize);
 
+EEPROM_Status EEPROM_ReadAsync(EEPROM_Operation* operation, uint16_t page, uint8_t* bytes, uint16_t size);
+EEPROM_Status EEPROM_WriteAsync(EEPROM_Operation* operation, uint16_t page, uint8_t* bytes, uint16_t size);
+EEPROM_Status EEPROM_getOperationStatus(const EEPROM_Operation* operation);
+uint8_t EEPROM_isIdle(void);
+// Advances queued operations without waiting. Call it from the main loop.
+void EEPROM_Step(void);
+
+// Device 0 is the one configured by EEPROM_Init() and used by the calls above.
+EEPROM_Status EEPROM_InitDevice(uint8_t device, EEPROM_Config config);
+EEPROM_Status EEPROM_ReadDevice(uint8_t device, uint16_t page, uint8_t* bytes, uint16_t size);
+EEPROM_Status EEPROM_WriteDevice(uint8_t device, uint16_t page, uint8_t* bytes, uint16_t size);
+// Integrity used by EEPROM_Read()/EEPROM_Write() and the device variants for the record of
+// that page and size, EEPROM_Integrity_Full removes it. EEPROM_Status_Error if the table is full.
+EEPROM_Status EEPROM_setRecordIntegrity(uint8_t device, uint16_t page, uint16_t size, uint8_t integrity);
+EEPROM_Status EEPROM_ReadDeviceEx(uint8_t device, uint16_t page, uint8_t* bytes, uint16_t size, uint8_t integrity);
+EEPROM_Status EEPROM_WriteDeviceEx(uint8_t device, uint16_t page, uint8_t* bytes, uint16_t size, uint8_t integrity);
+EEPROM_Status EEPROM_ReadDeviceAsync(uint8_t device, EEPROM_Operation* operation, uint16_t page, uint8_t* bytes, uint16_t size);
+EEPROM_Status EEPROM_WriteDeviceAsync(uint8_t device, EEPROM_Operation* operation, uint16_t page, uint8_t* bytes, uint16_t size);
+// Raw operations transfer the pages as they are, without the CRC page
+EEPROM_Status EEPROM_ReadDeviceRawAsync(uint8_t device, EEPROM_Operation* operation, uint16_t page, uint8_t* bytes, uint16_t size);
+EEPROM_Status EEPROM_WriteDeviceRawAsync(uint8_t device, EEPROM_Operation* operation, uint16_t page, uint8_t* bytes, uint16_t size);
+// Raw operations at any byte address. Writes are split at page boundaries, every read of
+// the driver is a single transfer of its full size, so a backend has to take it whole:
+// host/LinuxI2CBus refuses reads over 8192 bytes, the limit of an I2C_RDWR message.
+EEPROM_Status EEPROM_ReadDeviceBytesAsync(uint8_t device, EEPROM_Operation* operation, uint16_t address, uint8_t* bytes, uint16_t size);
+EEPROM_Status EEPROM_WriteDeviceBytesAsync(uint8_t device, EEPROM_Operation* operation, uint16_t address, uint8_t* bytes, uint16_t size);
+uint8_t EEPROM_isDeviceIdle(uint8_t device);
+uint16_t EEPROM_getDevicePageSize(uint8_t device);
+void EEPROM_addBackgroundTask(EEPROM_BackgroundTask* task);
+void EEPROM_addWriteObserver(EEPROM_WriteObserver* observer);
+EEPROM_Status EEPROM_getSpeedStats(uint8_t device, uint8_t speed, EEPROM_SpeedStats* stats);
+// 0 if the device has no bulk timing or fell back from it
+uint8_t EEPROM_isBulkTimingActive(uint8_t device);
+uint32_t EEPROM_getBusRecoveries(uint8_t device);
+// Blocking calls sleep in WFI instead of spinning in HAL_Delay during write cycles
+void EEPROM_setSleepOnWait(uint8_t enable);
+
+// One logical record dispatched to several devices, operations[i] serves devices[i].
+// Devices on different I2C peripherals transfer concurrently.
+// Mirror stores the whole record on every device, split stores an equal
+// part of it (with its own CRC) on each device.
+EEPROM_Status EEPROM_MirrorWriteAsync(EEPROM_Operation* operations, const uint8_t* devices, uint8_t count, uint16_t page, uint8_t* bytes, uint16_t size);
+EEPROM_Status EEPROM_SplitWriteAsync(EEPROM_Operation* operations, const uint8_t* devices, uint8_t count, uint16_t page, uint8_t* bytes, uint16_t size);
+EEPROM_Status EEPROM_SplitReadAsync(EEPROM_Operation* operations, const uint8_t* devices, uint8_t count, uint16_t page, uint8_t* bytes, uint16_t size);
+// Pending while any part is pending, otherwise the first failure or success
+EEPROM_Status EEPROM_getGroupStatus(const EEPROM_Operation* operations, uint8_t count);
+uint16_t EEPROM_getSplitPartSize(uint16_t size, uint8_t count);
+
+// Changes size bytes at offset inside a record written by EEPROM_Write(), blocking
+// like EEPROM_Write(): EEPROM_Status_Busy while operations of the device are queued.
+// Reads only the old bytes of the range and the stored CRC, writes the new bytes
+// and the CRC patched from the difference: the bus time doesn't depend on the
+// record size. A record that had a bad CRC keeps a bad CRC.
+// EEPROM_Status_Error unless recordSize is a multiple of 4 (the CRC unit covers whole
+// words only), size is 1 to EEPROM_PATCH_MAX_SIZE and the range lies inside the record.
+EEPROM_Status EEPROM_Patch(uint16_t page, uint16_t recordSize, uint16_t offset, const uint8_t* bytes, uint16_t size);
+EEPROM_Status EEPROM_PatchDevice(uint8_t device, uint16_t page, uint16_t recordSize, uint16_t offset, const uint8_t* bytes, uint16_t size);
+// CRC of the record after the range changed from oldBytes to newBytes. CRC-32 is
+// linear, the difference of the two CRCs is the CRC of the difference of the data.
+uint32_t EEPROM_patchCRC(CRC_HandleTypeDef* hCRC, uint32_t crc, uint16_t recordSize, uint16_t offset, 
+                         const uint8_t* oldBytes, const uint8_t* newBytes, uint16_t size);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,314 @@
+#include "EEPROM_Cache.h"
+
+// Whole pages of the device. A dirty page keeps the range changed since its
+// last write back, only that range goes to the EEPROM.
+class Cache {
+    struct Entry {
+        alignas(4) uint8_t bytes[EEPROM_CACHE_PAGE_SIZE];
+        uint32_t lastUse;
+        uint16_t page;
+        uint16_t dirtyStart;
+        uint16_t dirtyEnd;
+        bool isValid;
+        bool isReferenced;
+    };
+
+public:
+    auto init(const EEPROM_CacheConfig& config) -> EEPROM_Status {
+        auto pageSize = EEPROM_getDevicePageSize(config.device);
+        if(config.hCRC == nullptr || pageSize == 0) {
+            return EEPROM_Status_NotInitialized;
+        }
+        if(pageSize > EEPROM_CACHE_PAGE_SIZE) {
+            return EEPROM_Status_Error;
+        }
+        if(mPageSize != 0) {
+            if(auto status = invalidate(); status != EEPROM_Status_Sucess) {
+                return status;
+            }
+        }
+        mConfig = config;
+        mPageSize = pageSize;
+        mReport = EEPROM_CacheReport{};
+        return EEPROM_Status_Sucess;
+    }
+
+    auto read(uint16_t address, uint8_t* bytes, uint16_t size) -> EEPROM_Status {
+        if(mPageSize == 0) {
+            return EEPROM_Status_NotInitialized;
+        }
+        while(size > 0) {
+            Entry* entry{};
+            if(auto status = lookup(address / mPageSize, true, entry); status != EEPROM_Status_Sucess) {
+                return status;
+            }
+            auto offset = address % mPageSize;
+            auto count = getCount(offset, size);
+            for(uint16_t i = 0; i < count; ++i) {
+                bytes[i] = entry->bytes[offset + i];
+            }
+            address += count;
+            bytes += count;
+            size -= count;
+        }
+        return EEPROM_Status_Sucess;
+    }
+
+    // Write-through writes the bytes at once and updates the cached pages without allocating new ones
+    auto write(uint16_t address, const uint8_t* bytes, uint16_t size) -> EEPROM_Status {
+        if(mPageSize == 0) {
+            return EEPROM_Status_NotInitialized;
+        }
+        auto isWriteBack = mConfig.policy == EEPROM_CachePolicy_WriteBack;
+        if(!isWriteBack) {
+            if(auto status = writeDevice(address, const_cast<uint8_t*>(bytes), size); status != EEPROM_Status_Sucess) {
+                return status;
+            }
+        }
+        while(size > 0) {
+            auto offset = address % mPageSize;
+            auto count = getCount(offset, size);
+            Entry* entry = find(address / mPageSize);
+            // A page written as a whole doesn't have to be loaded first
+            if(entry == nullptr && isWriteBack) {
+                auto status = lookup(address / mPageSize, count != mPageSize, entry);
+                if(status != EEPROM_Status_Sucess) {
+                    return status;
+                }
+            }
+            if(entry != nullptr) {
+                for(uint16_t i = 0; i < count; ++i) {
+                    entry->bytes[offset + i] = bytes[i];
+                }
+                touch(*entry);
+                if(isWriteBack) {
+                    markDirty(*entry, offset, offset + count);
+                }
+            }
+            address += count;
+            bytes += count;
+            size -= count;
+        }
+        return EEPROM_Status_Sucess;
+    }
+
+    auto readRecord(uint16_t page, uint8_t* bytes, uint16_t size) -> EEPROM_Status {
+        uint32_t crc{};
+        auto status = read(page * mPageSize, bytes, size);
+        if(status == EEPROM_Status_Sucess) {
+            status = read(getCRCAddress(page, size), reinterpret_cast<uint8_t*>(&crc), sizeof(crc));
+        }
+        if(status != EEPROM_Status_Sucess) {
+            return status;
+        }
+        return crc == calcCRC(bytes, size) ? EEPROM_Status_Sucess : EEPROM_Status_InvalidCRC;
+    }
+
+    auto writeRecord(uint16_t page, uint8_t* bytes, uint16_t size) -> EEPROM_Status {
+        if(mPageSize == 0) {
+            return EEPROM_Status_NotInitialized;
+        }
+        auto crc = calcCRC(bytes, size);
+        auto status = write(page * mPageSize, bytes, size);
+        if(status != EEPROM_Status_Sucess) {
+            return status;
+        }
+        return write(getCRCAddress(page, size), reinterpret_cast<uint8_t*>(&crc), sizeof(crc));
+    }
+
+    auto flush() -> EEPROM_Status {
+        auto result = EEPROM_Status_Sucess;
+        for(auto& entry : mEntries) {
+            auto status = writeBack(entry);
+            if(result == EEPROM_Status_Sucess) {
+                result = status;
+            }
+        }
+        return result;
+    }
+
+    auto invalidate() -> EEPROM_Status {
+        auto status = flush();
+        if(status != EEPROM_Status_Sucess) {
+            return status;
+        }
+        for(auto& entry : mEntries) {
+            entry.isValid = false;
+        }
+        return EEPROM_Status_Sucess;
+    }
+
+    auto getReport() const -> EEPROM_CacheReport {
+        return mReport;
+    }
+
+private:
+    // Finds the page or takes a victim for it, loading its contents if asked to
+    auto lookup(uint16_t page, bool load, Entry*& entry) -> EEPROM_Status {
+        entry = find(page);
+        if(entry != nullptr) {
+            ++mReport.hits;
+            touch(*entry);
+            return EEPROM_Status_Sucess;
+        }
+        ++mReport.misses;
+        auto& victim = selectVictim();
+        if(victim.isValid) {
+            if(auto status = writeBack(victim); status != EEPROM_Status_Sucess) {
+                return status;
+            }
+            ++mReport.evictions;
+            victim.isValid = false;
+        }
+        if(load) {
+            EEPROM_Operation operation{};
+            auto status = EEPROM_ReadDeviceRawAsync(mConfig.device, &operation, page, victim.bytes, mPageSize);
+            if(status == EEPROM_Status_Sucess) {
+                status = wait(operation);
+            }
+            if(status != EEPROM_Status_Sucess) {
+                return status;
+            }
+        }
+        victim.page = page;
+        victim.isValid = true;
+        victim.dirtyStart = 0;
+        victim.dirtyEnd = 0;
+        touch(victim);
+        entry = &victim;
+        return EEPROM_Status_Sucess;
+    }
+
+    auto find(uint16_t page) -> Entry* {
+        for(auto& entry : mEntries) {
+            if(entry.isValid && entry.page == page) {
+                return &entry;
+            }
+        }
+        return nullptr;
+    }
+
+    auto selectVictim() -> Entry& {
+        for(auto& entry : mEntries) {
+            if(!entry.isValid) {
+                return entry;
+            }
+        }
+        if(mConfig.eviction == EEPROM_CacheEviction_Clock) {
+            // Every referenced page gets a second chance, the hand stops at the first other one
+            for(;;) {
+                auto& entry = mEntries[mHand];
+                mHand = (mHand + 1) % EEPROM_CACHE_PAGES;
+                if(!entry.isReferenced) {
+                    return entry;
+                }
+                entry.isReferenced = false;
+            }
+        }
+        auto victim = &mEntries[0];
+        for(auto& entry : mEntries) {
+            if(mClock - entry.lastUse > mClock - victim->lastUse) {
+                victim = &entry;
+            }
+        }
+        return *victim;
+    }
+
+    void touch(Entry& entry) {
+        entry.lastUse = ++mClock;
+        entry.isReferenced = true;
+    }
+
+    void markDirty(Entry& entry, uint16_t start, uint16_t end) {
+        if(entry.dirtyStart == entry.dirtyEnd) {
+            entry.dirtyStart = start;
+            entry.dirtyEnd = end;
+            return;
+        }
+        entry.dirtyStart = start < entry.dirtyStart ? start : entry.dirtyStart;
+        entry.dirtyEnd = end > entry.dirtyEnd ? end : entry.dirtyEnd;
+    }
+
+    auto writeBack(Entry& entry) -> EEPROM_Status {
+        if(!entry.isValid || entry.dirtyStart == entry.dirtyEnd) {
+            return EEPROM_Status_Sucess;
+        }
+        auto status = writeDevice(static_cast<uint16_t>(entry.page * mPageSize + entry.dirtyStart), 
+                                  entry.bytes + entry.dirtyStart, entry.dirtyEnd - entry.dirtyStart);
+        if(status == EEPROM_Status_Sucess) {
+            entry.dirtyStart = 0;
+            entry.dirtyEnd = 0;
+            ++mReport.writeBacks;
+        }
+        return status;
+    }
+
+    auto writeDevice(uint16_t address, uint8_t* bytes, uint16_t size) const -> EEPROM_Status {
+        EEPROM_Operation operation{};
+        auto status = EEPROM_WriteDeviceBytesAsync(mConfig.device, &operation, address, bytes, size);
+        if(status != EEPROM_Status_Sucess) {
+            return status;
+        }
+        return wait(operation);
+    }
+
+    static auto wait(EEPROM_Operation& operation) -> EEPROM_Status {
+        while(operation.status == EEPROM_Status_Pending) {
+            EEPROM_Step();
+        }
+        return operation.status;
+    }
+
+    auto getCount(uint16_t offset, uint16_t size) const -> uint16_t {
+        return mPageSize - offset < size ? static_cast<uint16_t>(mPageSize - offset) : size;
+    }
+
+    auto getCRCAddress(uint16_t page, uint16_t size) const -> uint16_t {
+        return static_cast<uint16_t>((page + size / mPageSize + 1) * mPageSize);
+    }
+
+    auto calcCRC(uint8_t* bytes, uint16_t size) const -> uint32_t {
+        return HAL_CRC_Calculate(mConfig.hCRC, reinterpret_cast<uint32_t*>(bytes), size / 4);
+    }
+
+    EEPROM_CacheConfig mConfig{};
+    uint16_t mPageSize{};
+    Entry mEntries[EEPROM_CACHE_PAGES]{};
+    uint32_t mClock{};
+    uint8_t mHand{};
+    EEPROM_CacheReport mReport{};
+};
+
+static auto sCache = Cache{};
+
+EEPROM_Status EEPROM_Cache_Init(EEPROM_CacheConfig config) {
+    return sCache.init(config);
+}
+
+EEPROM_Status EEPROM_Cache_Read(uint16_t address, uint8_t* bytes, uint16_t size) {
+    return sCache.read(address, bytes, size);
+}
+
+EEPROM_Status EEPROM_Cache_Write(uint16_t address, const uint8_t* bytes, uint16_t size) {
+    return sCache.write(address, bytes, size);
+}
+
+EEPROM_Status EEPROM_Cache_ReadRecord(uint16_t page, uint8_t* bytes, uint16_t size) {
+    return sCache.readRecord(page, bytes, size);
+}
+
+EEPROM_Status EEPROM_Cache_WriteRecord(uint16_t page, uint8_t* bytes, uint16_t size) {
+    return sCache.writeRecord(page, bytes, size);
+}
+
+EEPROM_Status EEPROM_Cache_Flush(void) {
+    return sCache.flush();
+}
+
+EEPROM_Status EEPROM_Cache_Invalidate(void) {
+    return sCache.invalidate();
+}
+
+EEPROM_CacheReport EEPROM_Cache_getReport(void) {
+    return sCache.getReport();
+}
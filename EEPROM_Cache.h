@@ -0,0 +1,60 @@
+#pragma once
+#include "EEPROM.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef EEPROM_CACHE_PAGES
+#define EEPROM_CACHE_PAGES 8
+#endif
+
+// Largest page size of the cached device
+#ifndef EEPROM_CACHE_PAGE_SIZE
+#define EEPROM_CACHE_PAGE_SIZE 64
+#endif
+
+typedef enum {
+  EEPROM_CachePolicy_WriteThrough,
+  // Writes stay in RAM until the page is evicted or EEPROM_Cache_Flush() is called
+  EEPROM_CachePolicy_WriteBack
+} EEPROM_CachePolicy;
+
+typedef enum {
+  EEPROM_CacheEviction_LRU,
+  // Second chance: cheaper bookkeeping, close to LRU for a small cache
+  EEPROM_CacheEviction_Clock
+} EEPROM_CacheEviction;
+
+typedef struct {
+  CRC_HandleTypeDef* hCRC;
+  uint8_t device;
+  uint8_t policy;
+  uint8_t eviction;
+} EEPROM_CacheConfig;
+
+typedef struct {
+  uint32_t hits;
+  uint32_t misses;
+  uint32_t evictions;
+  // Dirty pages written to the EEPROM, write-back only
+  uint32_t writeBacks;
+} EEPROM_CacheReport;
+
+// The cache must be the only path to the device, reads and writes past it aren't seen
+EEPROM_Status EEPROM_Cache_Init(EEPROM_CacheConfig config);
+// Raw bytes at a byte address of the device, blocking
+EEPROM_Status EEPROM_Cache_Read(uint16_t address, uint8_t* bytes, uint16_t size);
+EEPROM_Status EEPROM_Cache_Write(uint16_t address, const uint8_t* bytes, uint16_t size);
+// Records in the layout of EEPROM_ReadDevice()/EEPROM_WriteDevice(), bytes must be word aligned
+EEPROM_Status EEPROM_Cache_ReadRecord(uint16_t page, uint8_t* bytes, uint16_t size);
+EEPROM_Status EEPROM_Cache_WriteRecord(uint16_t page, uint8_t* bytes, uint16_t size);
+// Writes the dirty pages back, the first failure is returned
+EEPROM_Status EEPROM_Cache_Flush(void);
+// Drops every page, dirty ones are flushed first
+EEPROM_Status EEPROM_Cache_Invalidate(void);
+EEPROM_CacheReport EEPROM_Cache_getReport(void);
+
+#ifdef __cplusplus
+}
+#endif
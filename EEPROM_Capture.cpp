@@ -0,0 +1,35 @@
+#include "EEPROM_Capture.h"
+
+static_assert((EEPROM_CAPTURE_SIZE & (EEPROM_CAPTURE_SIZE - 1)) == 0, "EEPROM_CAPTURE_SIZE must be a power of two");
+
+#if EEPROM_CAPTURE_ENABLED
+static EEPROM_CaptureRecord sRecords[EEPROM_CAPTURE_SIZE];
+static uint32_t sHead;
+static uint32_t sTail;
+
+void EEPROM_Capture_record(uint8_t kind, uint8_t chip, uint16_t page, uint16_t size, uint16_t offset) {
+    sRecords[sHead++ & (EEPROM_CAPTURE_SIZE - 1)] = EEPROM_CaptureRecord{HAL_GetTick(), page, size, kind, chip, offset};
+}
+#endif
+
+void EEPROM_Capture_Drain(EEPROM_CaptureWriter writer) {
+    uint16_t count = 0;
+    uint32_t dropped = 0;
+#if EEPROM_CAPTURE_ENABLED
+    auto head = sHead;
+    if(head - sTail > EEPROM_CAPTURE_SIZE) {
+        dropped = head - sTail - EEPROM_CAPTURE_SIZE;
+        sTail = head - EEPROM_CAPTURE_SIZE;
+    }
+    count = static_cast<uint16_t>(head - sTail);
+#endif
+    auto header = EEPROM_CaptureHeader{EEPROM_CAPTURE_MAGIC, EEPROM_CAPTURE_VERSION, 
+                                       sizeof(EEPROM_CaptureRecord), count, dropped};
+    writer(reinterpret_cast<const uint8_t*>(&header), sizeof(header));
+#if EEPROM_CAPTURE_ENABLED
+    for(; sTail != head; ++sTail) {
+        auto& record = sRecords[sTail & (EEPROM_CAPTURE_SIZE - 1)];
+        writer(reinterpret_cast<const uint8_t*>(&record), sizeof(record));
+    }
+#endif
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include "main.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Build with EEPROM_CAPTURE_ENABLED=1 to record the workload of the driver
+// for tools/eeprom_replay, otherwise the capture points compile to nothing
+#ifndef EEPROM_CAPTURE_ENABLED
+#define EEPROM_CAPTURE_ENABLED 0
+#endif
+
+// Count of records in the ring, a power of two
+#ifndef EEPROM_CAPTURE_SIZE
+#define EEPROM_CAPTURE_SIZE 128
+#endif
+
+#define EEPROM_CAPTURE_MAGIC 0x50434545u
+#define EEPROM_CAPTURE_VERSION 2
+
+typedef enum {
+  EEPROM_CaptureKind_Read,
+  EEPROM_CaptureKind_Write,
+  EEPROM_CaptureKind_ReadRaw,
+  EEPROM_CaptureKind_WriteRaw,
+  // Set for operations queued with the *Async calls
+  EEPROM_CaptureKind_Async = 0x80
+} EEPROM_CaptureKind;
+
+typedef struct {
+  uint32_t tick;
+  uint16_t page;
+  uint16_t size;
+  uint8_t kind;
+  uint8_t chip;
+  // Byte offset into the first page, raw byte operations only
+  uint16_t offset;
+} EEPROM_CaptureRecord;
+
+// Every drain starts with this header, records lost to ring overruns since
+// the previous drain are counted in dropped
+typedef struct {
+  uint32_t magic;
+  uint8_t version;
+  uint8_t recordSize;
+  uint16_t count;
+  uint32_t dropped;
+} EEPROM_CaptureHeader;
+
+typedef void (*EEPROM_CaptureWriter)(const uint8_t* bytes, uint16_t size);
+
+// Writes the records captured since the previous drain. Call it often enough
+// to keep up with the workload, concatenated drains form the capture file.
+void EEPROM_Capture_Drain(EEPROM_CaptureWriter writer);
+
+#if EEPROM_CAPTURE_ENABLED
+void EEPROM_Capture_record(uint8_t kind, uint8_t chip, uint16_t page, uint16_t size, uint16_t offset);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,83 @@
+#include "EEPROM_Coroutine.h"
+
+#if defined(__cpp_impl_coroutine)
+
+namespace eeprom {
+
+namespace detail {
+
+alignas(max_align_t) static uint8_t sFrames[EEPROM_COROUTINE_MAX_TASKS][EEPROM_COROUTINE_FRAME_SIZE];
+static bool sFrameUsed[EEPROM_COROUTINE_MAX_TASKS];
+
+auto allocateFrame(size_t size) -> void* {
+    if(size > EEPROM_COROUTINE_FRAME_SIZE) {
+        return nullptr;
+    }
+    for(uint8_t i = 0; i < EEPROM_COROUTINE_MAX_TASKS; ++i) {
+        if(!sFrameUsed[i]) {
+            sFrameUsed[i] = true;
+            return sFrames[i];
+        }
+    }
+    return nullptr;
+}
+
+void freeFrame(void* frame) {
+    for(uint8_t i = 0; i < EEPROM_COROUTINE_MAX_TASKS; ++i) {
+        if(frame == sFrames[i]) {
+            sFrameUsed[i] = false;
+        }
+    }
+}
+
+}
+
+auto Executor::spawn(Task task) -> bool {
+    if(!task.isValid() || mTaskCount == EEPROM_COROUTINE_MAX_TASKS) {
+        return false;
+    }
+    auto handle = task.release();
+    handle.promise().executor = this;
+    ++mTaskCount;
+    schedule(handle);
+    return true;
+}
+
+void Executor::runOnce() {
+    EEPROM_Step();
+    // Coroutines scheduled while resuming wait for the next round
+    for(auto count = mReadyCount; count > 0; --count) {
+        auto handle = mReady[mReadyHead];
+        mReadyHead = (mReadyHead + 1) % EEPROM_COROUTINE_MAX_TASKS;
+        --mReadyCount;
+        resume(handle);
+    }
+}
+
+void Executor::run() {
+    while(mTaskCount != 0) {
+        runOnce();
+        if(mReadyCount == 0 && mTaskCount != 0) {
+            // The I2C interrupts and SysTick for the write cycle polling wake the core
+            __WFI();
+        }
+    }
+}
+
+// Every task waits for at most one operation, so the queue can't overflow
+void Executor::schedule(std::coroutine_handle<> handle) {
+    mReady[(mReadyHead + mReadyCount) % EEPROM_COROUTINE_MAX_TASKS] = handle;
+    ++mReadyCount;
+}
+
+void Executor::resume(std::coroutine_handle<> handle) {
+    handle.resume();
+    if(handle.done()) {
+        handle.destroy();
+        --mTaskCount;
+    }
+}
+
+}
+
+#endif
@@ -0,0 +1,203 @@
+#pragma once
+// C++20 interface: operations are awaited from coroutines run by eeprom::Executor.
+// Needs compiler support for coroutines, the header is empty otherwise.
+#include "EEPROM.h"
+
+#if defined(__cplusplus) && defined(__cpp_impl_coroutine)
+#include <coroutine>
+#include <span>
+#include <stddef.h>
+
+// Coroutine frames come from a static pool, there is no heap use at all
+#ifndef EEPROM_COROUTINE_MAX_TASKS
+#define EEPROM_COROUTINE_MAX_TASKS 4
+#endif
+
+#ifndef EEPROM_COROUTINE_FRAME_SIZE
+#define EEPROM_COROUTINE_FRAME_SIZE 256
+#endif
+
+namespace eeprom {
+
+class Executor;
+
+namespace detail {
+auto allocateFrame(size_t size) -> void*;
+void freeFrame(void* frame);
+}
+
+// Top level coroutine, started with Executor::spawn()
+class Task {
+public:
+    struct promise_type {
+        Executor* executor{};
+
+        static auto operator new(size_t size) noexcept -> void* {
+            return detail::allocateFrame(size);
+        }
+
+        static void operator delete(void* frame) {
+            detail::freeFrame(frame);
+        }
+
+        // The pool is exhausted or the frame is larger than EEPROM_COROUTINE_FRAME_SIZE
+        static auto get_return_object_on_allocation_failure() -> Task {
+            return Task{};
+        }
+
+        auto get_return_object() -> Task {
+            return Task{std::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+
+        auto initial_suspend() noexcept -> std::suspend_always {
+            return {};
+        }
+
+        auto final_suspend() noexcept -> std::suspend_always {
+            return {};
+        }
+
+        void return_void() {
+        }
+
+        void unhandled_exception() {
+        }
+    };
+
+    Task() = default;
+
+    Task(Task&& other) noexcept : mHandle(other.mHandle) {
+        other.mHandle = nullptr;
+    }
+
+    Task(const Task&) = delete;
+    auto operator=(const Task&) -> Task& = delete;
+    auto operator=(Task&&) -> Task& = delete;
+
+    ~Task() {
+        if(mHandle) {
+            mHandle.destroy();
+        }
+    }
+
+    auto isValid() const -> bool {
+        return static_cast<bool>(mHandle);
+    }
+
+private:
+    friend class Executor;
+
+    explicit Task(std::coroutine_handle<promise_type> handle) : mHandle(handle) {
+    }
+
+    auto release() -> std::coroutine_handle<promise_type> {
+        auto handle = mHandle;
+        mHandle = nullptr;
+        return handle;
+    }
+
+    std::coroutine_handle<promise_type> mHandle{};
+};
+
+// Single-threaded and meant for the main loop: steps the driver, resumes the
+// coroutines whose operations completed and sleeps in WFI when nothing is ready.
+class Executor {
+public:
+    // False if the task failed to allocate its frame or too many tasks are running
+    auto spawn(Task task) -> bool;
+    // One EEPROM_Step() and the coroutines it made ready
+    void runOnce();
+    // Until every spawned task returned
+    void run();
+
+    auto getTaskCount() const -> uint8_t {
+        return mTaskCount;
+    }
+
+    // Called from EEPROM_Step(), the coroutine is resumed after the step returns
+    void schedule(std::coroutine_handle<> handle);
+
+private:
+    void resume(std::coroutine_handle<> handle);
+
+    std::coroutine_handle<> mReady[EEPROM_COROUTINE_MAX_TASKS]{};
+    uint8_t mReadyHead{};
+    uint8_t mReadyCount{};
+    uint8_t mTaskCount{};
+};
+
+// One driver operation, lives in the frame of the awaiting coroutine
+class Operation {
+public:
+    using Submit = EEPROM_Status (*)(uint8_t, EEPROM_Operation*, uint16_t, uint8_t*, uint16_t);
+
+    Operation(Submit submit, uint8_t device, uint16_t page, std::span<uint8_t> bytes)
+        : mSubmit(submit), mDevice(device), mPage(page), mBytes(bytes) {
+    }
+
+    Operation(const Operation&) = delete;
+    auto operator=(const Operation&) -> Operation& = delete;
+
+    // A refused submit doesn't suspend, its status is the result
+    auto await_ready() -> bool {
+        mOperation.onComplete = &Operation::onComplete;
+        mOperation.context = this;
+        mSubmitStatus = mSubmit(mDevice, &mOperation, mPage, mBytes.data(), static_cast<uint16_t>(mBytes.size()));
+        return mSubmitStatus != EEPROM_Status_Sucess;
+    }
+
+    // Completion can't happen before the suspension, only EEPROM_Step() completes operations
+    void await_suspend(std::coroutine_handle<Task::promise_type> handle) {
+        mHandle = handle;
+        mExecutor = handle.promise().executor;
+    }
+
+    auto await_resume() const -> EEPROM_Status {
+        return mSubmitStatus != EEPROM_Status_Sucess ? mSubmitStatus : mOperation.status;
+    }
+
+private:
+    static void onComplete(EEPROM_Operation* operation) {
+        auto self = static_cast<Operation*>(operation->context);
+        self->mExecutor->schedule(self->mHandle);
+    }
+
+    EEPROM_Operation mOperation{};
+    Submit mSubmit;
+    uint8_t mDevice;
+    uint16_t mPage;
+    std::span<uint8_t> mBytes;
+    EEPROM_Status mSubmitStatus{EEPROM_Status_Sucess};
+    std::coroutine_handle<> mHandle{};
+    Executor* mExecutor{};
+};
+
+// co_await device.write(page, bytes) from an eeprom::Task
+class Device {
+public:
+    explicit Device(uint8_t device = 0) : mDevice(device) {
+    }
+
+    auto read(uint16_t page, std::span<uint8_t> bytes) const -> Operation {
+        return Operation{EEPROM_ReadDeviceAsync, mDevice, page, bytes};
+    }
+
+    auto write(uint16_t page, std::span<uint8_t> bytes) const -> Operation {
+        return Operation{EEPROM_WriteDeviceAsync, mDevice, page, bytes};
+    }
+
+    auto readRaw(uint16_t page, std::span<uint8_t> bytes) const -> Operation {
+        return Operation{EEPROM_ReadDeviceRawAsync, mDevice, page, bytes};
+    }
+
+    auto writeRaw(uint16_t page, std::span<uint8_t> bytes) const -> Operation {
+        return Operation{EEPROM_WriteDeviceRawAsync, mDevice, page, bytes};
+    }
+
+private:
+    uint8_t mDevice;
+};
+
+}
+
+#endif
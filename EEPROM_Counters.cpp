@@ -0,0 +1,285 @@
+#include "EEPROM_Counters.h"
+
+class Counters {
+    static constexpr uint32_t sMagic = 0x544E4345;
+    static constexpr auto sSlots = 2u;
+    static constexpr auto sGenerationRegister = 0u;
+    static constexpr auto sChecksumRegister = 1u;
+    static constexpr auto sFirstValueRegister = 2u;
+
+    // Size must stay a multiple of 4 for the CRC
+    struct Record {
+        uint32_t magic;
+        uint32_t generation;
+        uint32_t values[EEPROM_COUNTERS_MAX];
+    };
+
+public:
+    auto init(const EEPROM_CountersConfig& config) -> EEPROM_Status {
+        if(config.hRTC == nullptr || config.count == 0 || config.count > EEPROM_COUNTERS_MAX ||
+           config.firstRegister + sFirstValueRegister + config.count > RTC_BKP_NUMBER) {
+            return EEPROM_Status_Error;
+        }
+        if(EEPROM_getDevicePageSize(config.device) == 0) {
+            return EEPROM_Status_NotInitialized;
+        }
+        if(mFlushing) {
+            return EEPROM_Status_Busy;
+        }
+        mConfig = config;
+        mSource = recover();
+        mFlushedGeneration = mGeneration;
+        mFlushTick = HAL_GetTick();
+        mFlushRequested = false;
+        for(auto& threshold : mThresholds) {
+            threshold = 0;
+        }
+        if(!mTaskAdded) {
+            mTask.run = [](void* context) { static_cast<Counters*>(context)->step(); };
+            mTask.context = this;
+            EEPROM_addBackgroundTask(&mTask);
+            mTaskAdded = true;
+        }
+        return EEPROM_Status_Sucess;
+    }
+
+    auto isInitialized() const {
+        return mConfig.count != 0;
+    }
+
+    auto getRecoverySource() const {
+        return mSource;
+    }
+
+    auto getPagesCount(uint8_t device) const -> uint16_t {
+        auto pageSize = EEPROM_getDevicePageSize(device);
+        return pageSize == 0 ? 0 : sSlots * getRecordPagesCount(pageSize);
+    }
+
+    // Value, generation and checksum: three register writes, the checksum is patched instead of recomputed
+    void set(uint8_t index, uint32_t value) {
+        if(!isInitialized() || index >= mConfig.count) {
+            return;
+        }
+        auto previous = mValues[index];
+        auto generation = mGeneration + 1;
+        mChecksum ^= previous ^ value ^ mGeneration ^ generation;
+        mValues[index] = value;
+        mGeneration = generation;
+        writeRegister(sFirstValueRegister + index, value);
+        writeRegister(sGenerationRegister, generation);
+        writeRegister(sChecksumRegister, mChecksum);
+        auto threshold = mThresholds[index];
+        if(threshold != 0 && (previous < threshold) != (value < threshold)) {
+            mFlushRequested = true;
+        }
+    }
+
+    auto get(uint8_t index) const -> uint32_t {
+        return index < mConfig.count ? mValues[index] : 0;
+    }
+
+    void setThreshold(uint8_t index, uint32_t threshold) {
+        if(index < EEPROM_COUNTERS_MAX) {
+            mThresholds[index] = threshold;
+        }
+    }
+
+    void requestFlush() {
+        mFlushRequested = true;
+    }
+
+    auto flush() -> EEPROM_Status {
+        if(!isInitialized()) {
+            return EEPROM_Status_NotInitialized;
+        }
+        mFlushRequested = true;
+        while(mFlushRequested || mFlushing) {
+            EEPROM_Step();
+        }
+        return mFlushStatus;
+    }
+
+private:
+
+    void step() {
+        if(!isInitialized()) {
+            return;
+        }
+        if(mFlushing) {
+            if(mOperation.status == EEPROM_Status_Pending) {
+                return;
+            }
+            mFlushing = false;
+            mFlushStatus = mOperation.status;
+            if(mFlushStatus != EEPROM_Status_Sucess) {
+                return;
+            }
+            mFlushedGeneration = mRecord.generation;
+            ++mSlot;
+        }
+        auto isScheduled = mConfig.flushIntervalMs != 0 && HAL_GetTick() - mFlushTick >= mConfig.flushIntervalMs;
+        if(!mFlushRequested && !isScheduled) {
+            return;
+        }
+        if(mGeneration == mFlushedGeneration) {
+            mFlushRequested = false;
+            mFlushTick = HAL_GetTick();
+            mFlushStatus = EEPROM_Status_Sucess;
+            return;
+        }
+        startFlush();
+    }
+
+    // The record is a snapshot, updates during the write go to the next flush
+    void startFlush() {
+        mRecord.magic = sMagic;
+        mRecord.generation = mGeneration;
+        for(uint8_t i = 0; i < EEPROM_COUNTERS_MAX; ++i) {
+            mRecord.values[i] = mValues[i];
+        }
+        mFlushRequested = false;
+        mFlushTick = HAL_GetTick();
+        mOperation = EEPROM_Operation{};
+        mFlushStatus = EEPROM_WriteDeviceAsync(mConfig.device, &mOperation, getSlotPage(mSlot % sSlots),
+                                               reinterpret_cast<uint8_t*>(&mRecord), sizeof(mRecord));
+        mFlushing = mFlushStatus == EEPROM_Status_Sucess;
+    }
+
+    // The generation counts the hot updates, so the tier with the larger one is the newer
+    auto recover() -> EEPROM_CountersSource {
+        uint32_t backupValues[EEPROM_COUNTERS_MAX]{};
+        auto backupGeneration = readRegister(sGenerationRegister);
+        auto checksum = sMagic ^ backupGeneration;
+        for(uint8_t i = 0; i < mConfig.count; ++i) {
+            backupValues[i] = readRegister(sFirstValueRegister + i);
+            checksum ^= backupValues[i];
+        }
+        auto isBackupValid = checksum == readRegister(sChecksumRegister);
+
+        Record stored{};
+        auto isStoredValid = false;
+        for(uint8_t slot = 0; slot < sSlots; ++slot) {
+            Record record{};
+            if(EEPROM_ReadDevice(mConfig.device, getSlotPage(slot), reinterpret_cast<uint8_t*>(&record), 
+                                 sizeof(record)) != EEPROM_Status_Sucess || record.magic != sMagic) {
+                continue;
+            }
+            if(!isStoredValid || isNewer(record.generation, stored.generation)) {
+                stored = record;
+                mSlot = slot + 1;
+                isStoredValid = true;
+            }
+        }
+
+        auto source = EEPROM_CountersSource_None;
+        if(isBackupValid && (!isStoredValid || !isNewer(stored.generation, backupGeneration))) {
+            source = EEPROM_CountersSource_Backup;
+        } else if(isStoredValid) {
+            source = EEPROM_CountersSource_EEPROM;
+            backupGeneration = stored.generation;
+            for(uint8_t i = 0; i < EEPROM_COUNTERS_MAX; ++i) {
+                backupValues[i] = i < mConfig.count ? stored.values[i] : 0;
+            }
+        } else {
+            backupGeneration = 0;
+            for(auto& value : backupValues) {
+                value = 0;
+            }
+        }
+        mGeneration = backupGeneration;
+        mChecksum = sMagic ^ mGeneration;
+        for(uint8_t i = 0; i < EEPROM_COUNTERS_MAX; ++i) {
+            mValues[i] = backupValues[i];
+            mChecksum ^= i < mConfig.count ? mValues[i] : 0;
+        }
+        if(source != EEPROM_CountersSource_Backup) {
+            for(uint8_t i = 0; i < mConfig.count; ++i) {
+                writeRegister(sFirstValueRegister + i, mValues[i]);
+            }
+            writeRegister(sGenerationRegister, mGeneration);
+            writeRegister(sChecksumRegister, mChecksum);
+        }
+        return source;
+    }
+
+    auto getSlotPage(uint8_t slot) const -> uint16_t {
+        return mConfig.page + slot * getRecordPagesCount(EEPROM_getDevicePageSize(mConfig.device));
+    }
+
+    // Data pages and the CRC page, the layout of EEPROM_getBuffersPagesCount()
+    static auto getRecordPagesCount(uint16_t pageSize) -> uint16_t {
+        return sizeof(Record) / pageSize + 2;
+    }
+
+    static auto isNewer(uint32_t generation, uint32_t than) -> bool {
+        return static_cast<int32_t>(generation - than) > 0;
+    }
+
+    void writeRegister(uint32_t offset, uint32_t value) {
+        HAL_RTCEx_BKUPWrite(mConfig.hRTC, mConfig.firstRegister + offset, value);
+    }
+
+    auto readRegister(uint32_t offset) const -> uint32_t {
+        return HAL_RTCEx_BKUPRead(mConfig.hRTC, mConfig.firstRegister + offset);
+    }
+
+    EEPROM_CountersConfig mConfig{};
+    EEPROM_CountersSource mSource{EEPROM_CountersSource_None};
+    uint32_t mValues[EEPROM_COUNTERS_MAX]{};
+    uint32_t mThresholds[EEPROM_COUNTERS_MAX]{};
+    uint32_t mGeneration{};
+    uint32_t mChecksum{};
+    uint32_t mFlushedGeneration{};
+    uint32_t mFlushTick{};
+    volatile bool mFlushRequested{};
+    bool mFlushing{};
+    EEPROM_Status mFlushStatus{EEPROM_Status_Sucess};
+    uint8_t mSlot{};
+    Record mRecord{};
+    EEPROM_Operation mOperation{};
+    EEPROM_BackgroundTask mTask{};
+    bool mTaskAdded{};
+};
+
+static auto sCounters = Counters{};
+
+EEPROM_CountersConfig EEPROM_Counters_makeDefaultConfig(RTC_HandleTypeDef* hRTC, uint8_t count) {
+    return EEPROM_CountersConfig{hRTC, 1, count, 0, 0, 60000};
+}
+
+EEPROM_Status EEPROM_Counters_Init(EEPROM_CountersConfig config) {
+    return sCounters.init(config);
+}
+
+EEPROM_CountersSource EEPROM_Counters_getRecoverySource(void) {
+    return sCounters.getRecoverySource();
+}
+
+uint16_t EEPROM_Counters_getPagesCount(uint8_t device) {
+    return sCounters.getPagesCount(device);
+}
+
+void EEPROM_Counters_Add(uint8_t index, uint32_t delta) {
+    sCounters.set(index, sCounters.get(index) + delta);
+}
+
+void EEPROM_Counters_Set(uint8_t index, uint32_t value) {
+    sCounters.set(index, value);
+}
+
+uint32_t EEPROM_Counters_get(uint8_t index) {
+    return sCounters.get(index);
+}
+
+void EEPROM_Counters_setThreshold(uint8_t index, uint32_t threshold) {
+    sCounters.setThreshold(index, threshold);
+}
+
+void EEPROM_Counters_RequestFlush(void) {
+    sCounters.requestFlush();
+}
+
+EEPROM_Status EEPROM_Counters_Flush(void) {
+    return sCounters.flush();
+}
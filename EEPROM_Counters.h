@@ -0,0 +1,50 @@
+#pragma once
+#include "EEPROM.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef EEPROM_COUNTERS_MAX
+#define EEPROM_COUNTERS_MAX 8
+#endif
+
+typedef enum {
+  EEPROM_CountersSource_None,
+  EEPROM_CountersSource_Backup,
+  EEPROM_CountersSource_EEPROM
+} EEPROM_CountersSource;
+
+// The hot tier takes count + 2 backup registers from firstRegister on, the
+// EEPROM tier takes two records (A/B) from page on, see EEPROM_Counters_getPagesCount().
+typedef struct {
+  RTC_HandleTypeDef* hRTC;
+  uint8_t firstRegister;
+  uint8_t count;
+  uint8_t device;
+  uint16_t page;
+  // Scheduled flush of changed values, 0 - only thresholds and requests flush
+  uint32_t flushIntervalMs;
+} EEPROM_CountersConfig;
+
+EEPROM_CountersConfig EEPROM_Counters_makeDefaultConfig(RTC_HandleTypeDef* hRTC, uint8_t count);
+// Recovers the values from the newer of the backup registers and the EEPROM
+EEPROM_Status EEPROM_Counters_Init(EEPROM_CountersConfig config);
+EEPROM_CountersSource EEPROM_Counters_getRecoverySource(void);
+uint16_t EEPROM_Counters_getPagesCount(uint8_t device);
+
+// Hot updates only touch the backup registers. Not reentrant, call them from one context.
+void EEPROM_Counters_Add(uint8_t index, uint32_t delta);
+void EEPROM_Counters_Set(uint8_t index, uint32_t value);
+uint32_t EEPROM_Counters_get(uint8_t index);
+// A value crossing the threshold in either direction is flushed right away, 0 - disabled
+void EEPROM_Counters_setThreshold(uint8_t index, uint32_t threshold);
+
+// Safe from interrupts, e.g. the PVD power-fail warning: EEPROM_Step() starts the flush at once
+void EEPROM_Counters_RequestFlush(void);
+// Writes the changed values and waits for the write
+EEPROM_Status EEPROM_Counters_Flush(void);
+
+#ifdef __cplusplus
+}
+#endif
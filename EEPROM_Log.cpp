@@ -0,0 +1,301 @@
+#include "EEPROM_Log.h"
+#include <stddef.h>
+
+static_assert(sizeof(EEPROM_LogEntry) % 4 == 0, "EEPROM_LOG_PAYLOAD_SIZE must be a multiple of 4");
+
+class Log {
+    // First entry of every log page, so a search reads the index instead of the pages
+    struct IndexEntry {
+        uint32_t sequence;
+        uint32_t timestamp;
+    };
+
+public:
+    auto init(const EEPROM_LogConfig& config) -> EEPROM_Status {
+        auto pageSize = EEPROM_getDevicePageSize(config.device);
+        if(config.hCRC == nullptr || pageSize == 0) {
+            return EEPROM_Status_NotInitialized;
+        }
+        if(pageSize < sizeof(EEPROM_LogEntry) || config.pageCount == 0) {
+            return EEPROM_Status_Error;
+        }
+        if(EEPROM_getGroupStatus(mOperations, 2) == EEPROM_Status_Pending) {
+            return EEPROM_Status_Busy;
+        }
+        mConfig = config;
+        mPageSize = pageSize;
+        mEntriesPerPage = pageSize / sizeof(EEPROM_LogEntry);
+        mCapacity = static_cast<uint32_t>(mEntriesPerPage) * config.pageCount;
+        auto status = findHead();
+        if(status != EEPROM_Status_Sucess) {
+            mCapacity = 0;
+        }
+        return status;
+    }
+
+    auto isInitialized() const {
+        return mCapacity != 0;
+    }
+
+    auto append(uint32_t timestamp, const uint8_t* payload, uint16_t size) -> EEPROM_Status {
+        if(!isInitialized()) {
+            return EEPROM_Status_NotInitialized;
+        }
+        if(size > EEPROM_LOG_PAYLOAD_SIZE) {
+            return EEPROM_Status_Error;
+        }
+        // A lost entry would end the log at the next boot, so the previous one is retried first
+        if(auto status = waitForWrites(); status != EEPROM_Status_Sucess) {
+            if(auto retryStatus = submitWrites(); retryStatus != EEPROM_Status_Sucess) {
+                return retryStatus;
+            }
+            if(auto retryStatus = waitForWrites(); retryStatus != EEPROM_Status_Sucess) {
+                return retryStatus;
+            }
+        }
+        mEntry = EEPROM_LogEntry{};
+        mEntry.sequence = mNext;
+        mEntry.timestamp = timestamp;
+        for(uint16_t i = 0; i < size; ++i) {
+            mEntry.payload[i] = payload[i];
+        }
+        mEntry.crc = calcCRC(mEntry);
+        mIsPageStart = getSlot(mNext) % mEntriesPerPage == 0;
+        mIndexEntry = IndexEntry{mNext, timestamp};
+        auto status = submitWrites();
+        if(status == EEPROM_Status_Sucess) {
+            ++mNext;
+        }
+        return status;
+    }
+
+    auto read(uint32_t sequence, EEPROM_LogEntry& entry) -> EEPROM_Status {
+        if(!isInitialized()) {
+            return EEPROM_Status_NotInitialized;
+        }
+        if(sequence - getFirstSequence() >= mNext - getFirstSequence()) {
+            return EEPROM_Status_Error;
+        }
+        waitForWrites();
+        auto status = readSlot(getSlot(sequence), entry);
+        if(status == EEPROM_Status_Sucess && entry.sequence != sequence) {
+            return EEPROM_Status_InvalidCRC;
+        }
+        return status;
+    }
+
+    auto getFirstSequence() const -> uint32_t {
+        return mNext > mCapacity ? mNext - mCapacity : 0;
+    }
+
+    auto getNextSequence() const -> uint32_t {
+        return mNext;
+    }
+
+    // Binary search over the page starts in the index, then a scan of at most one page
+    auto findSince(uint32_t timestamp, uint32_t& sequence) -> EEPROM_Status {
+        if(!isInitialized()) {
+            return EEPROM_Status_NotInitialized;
+        }
+        waitForWrites();
+        auto first = getFirstSequence();
+        auto firstPageStart = (first + mEntriesPerPage - 1) / mEntriesPerPage * mEntriesPerPage;
+        uint32_t pageStarts = firstPageStart < mNext ? (mNext - 1 - firstPageStart) / mEntriesPerPage + 1 : 0;
+        uint32_t low = 0;
+        uint32_t high = pageStarts;
+        while(low < high) {
+            auto middle = (low + high) / 2;
+            uint32_t pageTimestamp{};
+            auto status = readPageTimestamp(firstPageStart + middle * mEntriesPerPage, pageTimestamp);
+            if(status != EEPROM_Status_Sucess && status != EEPROM_Status_InvalidCRC) {
+                return status;
+            }
+            if(status == EEPROM_Status_Sucess && pageTimestamp >= timestamp) {
+                high = middle;
+            } else {
+                low = middle + 1;
+            }
+        }
+        // Entries before the first page start survive from a page the newest entries partly overwrote
+        auto scanFrom = low == 0 ? first : firstPageStart + (low - 1) * mEntriesPerPage;
+        auto scanTo = low < pageStarts ? firstPageStart + low * mEntriesPerPage : mNext;
+        for(auto current = scanFrom; current != scanTo; ++current) {
+            EEPROM_LogEntry entry{};
+            auto status = readSlot(getSlot(current), entry);
+            if(status != EEPROM_Status_Sucess && status != EEPROM_Status_InvalidCRC) {
+                return status;
+            }
+            if(status == EEPROM_Status_Sucess && entry.sequence == current && entry.timestamp >= timestamp) {
+                sequence = current;
+                return EEPROM_Status_Sucess;
+            }
+        }
+        sequence = scanTo;
+        return EEPROM_Status_Sucess;
+    }
+
+    auto getIndexPagesCount(uint8_t device, uint16_t pageCount) const -> uint16_t {
+        auto pageSize = EEPROM_getDevicePageSize(device);
+        if(pageSize == 0) {
+            return 0;
+        }
+        return static_cast<uint16_t>((pageCount * sizeof(IndexEntry) + pageSize - 1) / pageSize);
+    }
+
+private:
+
+    // Entry i lives in slot i % capacity. Before the head the sequence grows by one
+    // per slot, from the head on the slots hold the previous round or nothing.
+    auto findHead() -> EEPROM_Status {
+        EEPROM_LogEntry entry{};
+        auto status = readSlot(0, entry);
+        if(status == EEPROM_Status_InvalidCRC) {
+            // The newest entry may be the torn one in slot 0 after a wrap
+            status = readSlot(mCapacity - 1, entry);
+            if(status == EEPROM_Status_InvalidCRC) {
+                mNext = 0;
+                return EEPROM_Status_Sucess;
+            }
+            mNext = entry.sequence + 1;
+            return status;
+        }
+        if(status != EEPROM_Status_Sucess) {
+            return status;
+        }
+        auto first = entry.sequence;
+        uint32_t low = 1;
+        uint32_t high = mCapacity;
+        while(low < high) {
+            auto middle = (low + high) / 2;
+            status = readSlot(middle, entry);
+            if(status != EEPROM_Status_Sucess && status != EEPROM_Status_InvalidCRC) {
+                return status;
+            }
+            if(status == EEPROM_Status_Sucess && entry.sequence == first + middle) {
+                low = middle + 1;
+            } else {
+                high = middle;
+            }
+        }
+        mNext = first + low;
+        return EEPROM_Status_Sucess;
+    }
+
+    auto submitWrites() -> EEPROM_Status {
+        auto slot = getSlot(mEntry.sequence);
+        auto status = EEPROM_WriteDeviceBytesAsync(mConfig.device, &mOperations[0], getSlotAddress(slot),
+                                                   reinterpret_cast<uint8_t*>(&mEntry), sizeof(mEntry));
+        if(status != EEPROM_Status_Sucess || !mIsPageStart) {
+            mOperations[1] = EEPROM_Operation{};
+            return status;
+        }
+        return EEPROM_WriteDeviceBytesAsync(mConfig.device, &mOperations[1], getIndexAddress(slot / mEntriesPerPage),
+                                            reinterpret_cast<uint8_t*>(&mIndexEntry), sizeof(mIndexEntry));
+    }
+
+    auto waitForWrites() -> EEPROM_Status {
+        while(EEPROM_getGroupStatus(mOperations, 2) == EEPROM_Status_Pending) {
+            EEPROM_Step();
+        }
+        return EEPROM_getGroupStatus(mOperations, 2);
+    }
+
+    // A stale or missing index entry falls back to the first entry of the page
+    auto readPageTimestamp(uint32_t pageStart, uint32_t& timestamp) -> EEPROM_Status {
+        IndexEntry indexEntry{};
+        auto page = getSlot(pageStart) / mEntriesPerPage;
+        auto status = readBytes(getIndexAddress(page), reinterpret_cast<uint8_t*>(&indexEntry), sizeof(indexEntry));
+        if(status == EEPROM_Status_Sucess && indexEntry.sequence == pageStart) {
+            timestamp = indexEntry.timestamp;
+            return status;
+        }
+        EEPROM_LogEntry entry{};
+        status = readSlot(getSlot(pageStart), entry);
+        if(status == EEPROM_Status_Sucess && entry.sequence != pageStart) {
+            return EEPROM_Status_InvalidCRC;
+        }
+        timestamp = entry.timestamp;
+        return status;
+    }
+
+    auto readSlot(uint32_t slot, EEPROM_LogEntry& entry) -> EEPROM_Status {
+        auto status = readBytes(getSlotAddress(slot), reinterpret_cast<uint8_t*>(&entry), sizeof(entry));
+        if(status != EEPROM_Status_Sucess) {
+            return status;
+        }
+        if(entry.crc != calcCRC(entry) || getSlot(entry.sequence) != slot) {
+            return EEPROM_Status_InvalidCRC;
+        }
+        return EEPROM_Status_Sucess;
+    }
+
+    auto readBytes(uint16_t address, uint8_t* buffer, uint16_t size) const -> EEPROM_Status {
+        EEPROM_Operation operation{};
+        auto status = EEPROM_ReadDeviceBytesAsync(mConfig.device, &operation, address, buffer, size);
+        if(status != EEPROM_Status_Sucess) {
+            return status;
+        }
+        while(operation.status == EEPROM_Status_Pending) {
+            EEPROM_Step();
+        }
+        return operation.status;
+    }
+
+    auto getSlot(uint32_t sequence) const -> uint32_t {
+        return sequence % mCapacity;
+    }
+
+    auto getSlotAddress(uint32_t slot) const -> uint16_t {
+        auto page = mConfig.firstPage + slot / mEntriesPerPage;
+        return static_cast<uint16_t>(page * mPageSize + slot % mEntriesPerPage * sizeof(EEPROM_LogEntry));
+    }
+
+    auto getIndexAddress(uint32_t page) const -> uint16_t {
+        auto indexStart = (mConfig.firstPage + mConfig.pageCount) * mPageSize;
+        return static_cast<uint16_t>(indexStart + page * sizeof(IndexEntry));
+    }
+
+    auto calcCRC(EEPROM_LogEntry& entry) const -> uint32_t {
+        return HAL_CRC_Calculate(mConfig.hCRC, reinterpret_cast<uint32_t*>(&entry), offsetof(EEPROM_LogEntry, crc) / 4);
+    }
+
+    EEPROM_LogConfig mConfig{};
+    uint16_t mPageSize{};
+    uint16_t mEntriesPerPage{};
+    uint32_t mCapacity{};
+    uint32_t mNext{};
+    EEPROM_LogEntry mEntry{};
+    IndexEntry mIndexEntry{};
+    bool mIsPageStart{};
+    EEPROM_Operation mOperations[2]{};
+};
+
+static auto sLog = Log{};
+
+EEPROM_Status EEPROM_Log_Init(EEPROM_LogConfig config) {
+    return sLog.init(config);
+}
+
+uint16_t EEPROM_Log_getIndexPagesCount(uint8_t device, uint16_t pageCount) {
+    return sLog.getIndexPagesCount(device, pageCount);
+}
+
+EEPROM_Status EEPROM_Log_Append(uint32_t timestamp, const uint8_t* payload, uint16_t size) {
+    return sLog.append(timestamp, payload, size);
+}
+
+EEPROM_Status EEPROM_Log_Read(uint32_t sequence, EEPROM_LogEntry* entry) {
+    return sLog.read(sequence, *entry);
+}
+
+uint32_t EEPROM_Log_getFirstSequence(void) {
+    return sLog.getFirstSequence();
+}
+
+uint32_t EEPROM_Log_getNextSequence(void) {
+    return sLog.getNextSequence();
+}
+
+EEPROM_Status EEPROM_Log_findSince(uint32_t timestamp, uint32_t* sequence) {
+    return sLog.findSince(timestamp, *sequence);
+}
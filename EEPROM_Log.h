@@ -0,0 +1,45 @@
+#pragma once
+#include "EEPROM.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Must be a multiple of 4, the checksum uses the CRC unit
+#ifndef EEPROM_LOG_PAYLOAD_SIZE
+#define EEPROM_LOG_PAYLOAD_SIZE 8
+#endif
+
+typedef struct {
+  uint32_t sequence;
+  uint32_t timestamp;
+  uint8_t payload[EEPROM_LOG_PAYLOAD_SIZE];
+  uint32_t crc;
+} EEPROM_LogEntry;
+
+// The log takes pageCount pages from firstPage on, the index follows them,
+// see EEPROM_Log_getIndexPagesCount(). Entries never cross a page boundary.
+typedef struct {
+  CRC_HandleTypeDef* hCRC;
+  uint8_t device;
+  uint16_t firstPage;
+  uint16_t pageCount;
+} EEPROM_LogConfig;
+
+// Finds the head with a binary search over the sequence numbers
+EEPROM_Status EEPROM_Log_Init(EEPROM_LogConfig config);
+uint16_t EEPROM_Log_getIndexPagesCount(uint8_t device, uint16_t pageCount);
+// Timestamps must not decrease. The entry is written in the background by
+// EEPROM_Step(), the call waits only while the previous entry is still written.
+EEPROM_Status EEPROM_Log_Append(uint32_t timestamp, const uint8_t* payload, uint16_t size);
+// Entries older than the capacity of the log are overwritten
+EEPROM_Status EEPROM_Log_Read(uint32_t sequence, EEPROM_LogEntry* entry);
+// The first sequence of the log, and the one the next entry gets
+uint32_t EEPROM_Log_getFirstSequence(void);
+uint32_t EEPROM_Log_getNextSequence(void);
+// First entry with timestamp >= the given one, or the next sequence if there is none
+EEPROM_Status EEPROM_Log_findSince(uint32_t timestamp, uint32_t* sequence);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,262 @@
+#include "EEPROM_Mirror.h"
+
+class Mirror {
+    enum CopyStage : uint8_t {
+        CopyStage_Idle,
+        CopyStage_Reading,
+        CopyStage_Writing
+    };
+
+    struct Resync {
+        uint8_t source;
+        uint8_t target;
+        uint16_t page;
+        uint16_t pageCount;
+        uint16_t copied;
+        uint16_t retryDelay;
+        uint32_t retryTick;
+        bool active;
+    };
+
+public:
+    auto init(uint8_t primary, uint8_t secondary) {
+        auto pageSize = EEPROM_getDevicePageSize(primary);
+        if(pageSize == 0 || primary == secondary || pageSize != EEPROM_getDevicePageSize(secondary)) {
+            return EEPROM_Status_NotInitialized;
+        }
+        if(pageSize > EEPROM_MIRROR_SCRATCH_SIZE) {
+            return EEPROM_Status_Error;
+        }
+        if(mCopyStage != CopyStage_Idle) {
+            return EEPROM_Status_Busy;
+        }
+        mDevices[0] = primary;
+        mDevices[1] = secondary;
+        mPageSize = pageSize;
+        for(auto& resync : mResyncs) {
+            resync.active = false;
+        }
+        mTask.run = [](void* context) { static_cast<Mirror*>(context)->step(); };
+        mTask.context = this;
+        EEPROM_addBackgroundTask(&mTask);
+        return EEPROM_Status_Sucess;
+    }
+
+    auto isInitialized() const {
+        return mPageSize != 0;
+    }
+
+    // Both copies are queued at once, so the write cycles of the chips overlap
+    auto write(uint16_t page, uint8_t* buffer, uint16_t size) -> EEPROM_Status {
+        if(!isInitialized()) {
+            return EEPROM_Status_NotInitialized;
+        }
+        cancelResyncs(page, size);
+        EEPROM_Operation operations[2]{};
+        auto status = EEPROM_MirrorWriteAsync(operations, mDevices, 2, page, buffer, size);
+        wait(operations, 2);
+        if(status != EEPROM_Status_Sucess) {
+            return status;
+        }
+        auto primaryStatus = operations[0].status;
+        auto secondaryStatus = operations[1].status;
+        auto isScheduled = true;
+        if(primaryStatus == EEPROM_Status_Sucess && secondaryStatus != EEPROM_Status_Sucess) {
+            isScheduled = scheduleResync(mDevices[0], mDevices[1], page, size);
+        } else if(primaryStatus != EEPROM_Status_Sucess && secondaryStatus == EEPROM_Status_Sucess) {
+            isScheduled = scheduleResync(mDevices[1], mDevices[0], page, size);
+        } else {
+            return primaryStatus;
+        }
+        return isScheduled ? EEPROM_Status_Sucess : EEPROM_Status_Error;
+    }
+
+    auto read(uint16_t page, uint8_t* buffer, uint16_t size) -> EEPROM_Status {
+        if(!isInitialized()) {
+            return EEPROM_Status_NotInitialized;
+        }
+        auto first = selectReadDevice(page, size);
+        auto second = mDevices[0] == first ? mDevices[1] : mDevices[0];
+        auto status = readFrom(first, page, buffer, size);
+        if(status == EEPROM_Status_Sucess || isStale(second, page, size)) {
+            return status;
+        }
+        status = readFrom(second, page, buffer, size);
+        if(status == EEPROM_Status_Sucess) {
+            scheduleResync(second, first, page, size);
+        }
+        return status;
+    }
+
+    auto getResyncCount() const {
+        uint8_t count = 0;
+        for(auto& resync : mResyncs) {
+            count += resync.active;
+        }
+        return count;
+    }
+
+private:
+
+    // Copies one page at a time, raw, including the CRC page
+    void step() {
+        switch(mCopyStage) {
+            case CopyStage_Idle:
+                for(auto& resync : mResyncs) {
+                    if(resync.active && static_cast<int32_t>(HAL_GetTick() - resync.retryTick) >= 0) {
+                        startCopy(resync);
+                        break;
+                    }
+                }
+                break;
+            case CopyStage_Reading:
+                if(mCopyOperation.status == EEPROM_Status_Pending) {
+                    break;
+                }
+                mCopyStage = CopyStage_Idle;
+                if(!mCopy->active) {
+                    break;
+                }
+                if(mCopyOperation.status != EEPROM_Status_Sucess ||
+                   EEPROM_WriteDeviceRawAsync(mCopy->target, &mCopyOperation, mCopy->page + mCopy->copied, 
+                                              mScratch, mPageSize) != EEPROM_Status_Sucess) {
+                    delayRetry(*mCopy);
+                    break;
+                }
+                mCopyStage = CopyStage_Writing;
+                break;
+            case CopyStage_Writing:
+                if(mCopyOperation.status == EEPROM_Status_Pending) {
+                    break;
+                }
+                mCopyStage = CopyStage_Idle;
+                if(!mCopy->active) {
+                    break;
+                }
+                if(mCopyOperation.status != EEPROM_Status_Sucess) {
+                    delayRetry(*mCopy);
+                    break;
+                }
+                mCopy->retryDelay = EEPROM_MIRROR_RETRY_MS;
+                if(++mCopy->copied == mCopy->pageCount) {
+                    mCopy->active = false;
+                }
+                break;
+            default:
+                break;
+        }
+    }
+
+    void startCopy(Resync& resync) {
+        auto status = EEPROM_ReadDeviceRawAsync(resync.source, &mCopyOperation, resync.page + resync.copied, 
+                                                mScratch, mPageSize);
+        if(status != EEPROM_Status_Sucess) {
+            delayRetry(resync);
+            return;
+        }
+        mCopy = &resync;
+        mCopyStage = CopyStage_Reading;
+    }
+
+    // The copy goes on from the page that failed, the resync stays until it is complete
+    static void delayRetry(Resync& resync) {
+        resync.retryTick = HAL_GetTick() + resync.retryDelay;
+        resync.retryDelay = resync.retryDelay < EEPROM_MIRROR_RETRY_MAX_MS / 2 ? resync.retryDelay * 2 : EEPROM_MIRROR_RETRY_MAX_MS;
+    }
+
+    auto scheduleResync(uint8_t source, uint8_t target, uint16_t page, uint16_t size) -> bool {
+        cancelResyncs(page, size);
+        for(auto& resync : mResyncs) {
+            if(!resync.active) {
+                // Data pages and the CRC page, the layout of EEPROM_getBuffersPagesCount()
+                resync = Resync{source, target, page, static_cast<uint16_t>(size / mPageSize + 2), 0, 
+                                EEPROM_MIRROR_RETRY_MS, HAL_GetTick(), true};
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // A new write refreshes both copies, a copy in flight must not overwrite it
+    void cancelResyncs(uint16_t page, uint16_t size) {
+        auto end = page + size / mPageSize + 2;
+        for(auto& resync : mResyncs) {
+            if(resync.active && resync.page < end && page < resync.page + resync.pageCount) {
+                resync.active = false;
+            }
+        }
+    }
+
+    // The copy a resync still has to refresh holds old data
+    auto isStale(uint8_t device, uint16_t page, uint16_t size) const -> bool {
+        auto end = page + size / mPageSize + 2;
+        for(auto& resync : mResyncs) {
+            if(resync.active && resync.target == device && resync.page < end && page < resync.page + resync.pageCount) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // An idle device that isn't stale, otherwise the read queues behind the busy one
+    auto selectReadDevice(uint16_t page, uint16_t size) -> uint8_t {
+        if(isStale(mDevices[0], page, size)) {
+            return mDevices[1];
+        }
+        if(isStale(mDevices[1], page, size)) {
+            return mDevices[0];
+        }
+        if(EEPROM_isDeviceIdle(mDevices[0])) {
+            return mDevices[0];
+        }
+        if(EEPROM_isDeviceIdle(mDevices[1])) {
+            return mDevices[1];
+        }
+        mNextRead ^= 1;
+        return mDevices[mNextRead];
+    }
+
+    auto readFrom(uint8_t device, uint16_t page, uint8_t* buffer, uint16_t size) -> EEPROM_Status {
+        EEPROM_Operation operation{};
+        auto status = EEPROM_ReadDeviceAsync(device, &operation, page, buffer, size);
+        if(status != EEPROM_Status_Sucess) {
+            return status;
+        }
+        wait(&operation, 1);
+        return operation.status;
+    }
+
+    static void wait(const EEPROM_Operation* operations, uint8_t count) {
+        while(EEPROM_getGroupStatus(operations, count) == EEPROM_Status_Pending) {
+            EEPROM_Step();
+        }
+    }
+
+    uint8_t mDevices[2]{};
+    uint16_t mPageSize{};
+    uint8_t mNextRead{};
+    Resync mResyncs[EEPROM_MIRROR_MAX_RESYNCS]{};
+    Resync* mCopy{};
+    CopyStage mCopyStage{CopyStage_Idle};
+    EEPROM_Operation mCopyOperation{};
+    uint8_t mScratch[EEPROM_MIRROR_SCRATCH_SIZE]{};
+    EEPROM_BackgroundTask mTask{};
+};
+
+static auto sMirror = Mirror{};
+
+EEPROM_Status EEPROM_Mirror_Init(uint8_t primary, uint8_t secondary) {
+    return sMirror.init(primary, secondary);
+}
+
+EEPROM_Status EEPROM_Mirror_Read(uint16_t page, uint8_t* bytes, uint16_t size) {
+    return sMirror.read(page, bytes, size);
+}
+
+EEPROM_Status EEPROM_Mirror_Write(uint16_t page, uint8_t* bytes, uint16_t size) {
+    return sMirror.write(page, bytes, size);
+}
+
+uint8_t EEPROM_Mirror_getResyncCount(void) {
+    return sMirror.getResyncCount();
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include "EEPROM.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Resyncs waiting for the background copy. A write that diverges while all of them
+// are taken returns EEPROM_Status_Error, the copies differ until the record is rewritten.
+#ifndef EEPROM_MIRROR_MAX_RESYNCS
+#define EEPROM_MIRROR_MAX_RESYNCS 4
+#endif
+
+// A failed copy is retried after this delay, doubled on every further failure up to the maximum
+#ifndef EEPROM_MIRROR_RETRY_MS
+#define EEPROM_MIRROR_RETRY_MS 10
+#endif
+
+#ifndef EEPROM_MIRROR_RETRY_MAX_MS
+#define EEPROM_MIRROR_RETRY_MAX_MS 1000
+#endif
+
+// Must hold one page of the mirrored devices
+#ifndef EEPROM_MIRROR_SCRATCH_SIZE
+#define EEPROM_MIRROR_SCRATCH_SIZE 128
+#endif
+
+// Both devices must be initialized with EEPROM_InitDevice() and use the same page size.
+// Divergent copies are copied from the good device by EEPROM_Step() until the copy succeeds,
+// reads never go to the stale copy meanwhile.
+EEPROM_Status EEPROM_Mirror_Init(uint8_t primary, uint8_t secondary);
+EEPROM_Status EEPROM_Mirror_Read(uint16_t page, uint8_t* bytes, uint16_t size);
+EEPROM_Status EEPROM_Mirror_Write(uint16_t page, uint8_t* bytes, uint16_t size);
+uint8_t EEPROM_Mirror_getResyncCount(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,208 @@
+#include "EEPROM_Parity.h"
+
+class Parity {
+    static constexpr uint8_t sMinDevices = 3;
+public:
+    auto init(const uint8_t* devices, uint8_t count) {
+        if(count < sMinDevices || count > EEPROM_MAX_DEVICES) {
+            return EEPROM_Status_NotInitialized;
+        }
+        auto pageSize = EEPROM_getDevicePageSize(devices[0]);
+        for(uint8_t i = 0; i < count; ++i) {
+            if(pageSize == 0 || EEPROM_getDevicePageSize(devices[i]) != pageSize) {
+                return EEPROM_Status_NotInitialized;
+            }
+            // Two parts on one device would overwrite each other
+            for(uint8_t j = 0; j < i; ++j) {
+                if(devices[j] == devices[i]) {
+                    return EEPROM_Status_NotInitialized;
+                }
+            }
+        }
+        for(uint8_t i = 0; i < count; ++i) {
+            mDevices[i] = devices[i];
+        }
+        mCount = count;
+        mPageSize = pageSize;
+        return EEPROM_Status_Sucess;
+    }
+
+    auto isInitialized() const {
+        return mCount != 0;
+    }
+
+    // Data and parity parts are queued together, the parity write cycle
+    // overlaps the data write cycles instead of following them
+    auto write(uint16_t page, uint8_t* buffer, uint16_t size) -> EEPROM_Status {
+        if(!isInitialized()) {
+            return EEPROM_Status_NotInitialized;
+        }
+        auto partSize = getPartSize(size);
+        if(partSize == 0 || partSize > EEPROM_PARITY_MAX_PART_SIZE) {
+            return EEPROM_Status_Error;
+        }
+        uint8_t dataDevices[EEPROM_MAX_DEVICES]{};
+        auto parityDevice = mapDevices(page, dataDevices);
+        calcParity(buffer, size, partSize, mParity);
+        EEPROM_Operation operations[EEPROM_MAX_DEVICES]{};
+        auto dataCount = mCount - 1;
+        auto status = EEPROM_SplitWriteAsync(operations, dataDevices, dataCount, page, buffer, size);
+        if(status == EEPROM_Status_Sucess) {
+            status = EEPROM_WriteDeviceAsync(parityDevice, &operations[dataCount], page, mParity, partSize);
+        }
+        wait(operations, mCount);
+        if(status != EEPROM_Status_Sucess) {
+            return status;
+        }
+        return EEPROM_getGroupStatus(operations, mCount);
+    }
+
+    auto read(uint16_t page, uint8_t* buffer, uint16_t size) -> EEPROM_Status {
+        if(!isInitialized()) {
+            return EEPROM_Status_NotInitialized;
+        }
+        auto partSize = getPartSize(size);
+        if(partSize == 0 || partSize > EEPROM_PARITY_MAX_PART_SIZE) {
+            return EEPROM_Status_Error;
+        }
+        uint8_t dataDevices[EEPROM_MAX_DEVICES]{};
+        auto parityDevice = mapDevices(page, dataDevices);
+        EEPROM_Operation operations[EEPROM_MAX_DEVICES]{};
+        auto dataCount = mCount - 1;
+        auto status = EEPROM_SplitReadAsync(operations, dataDevices, dataCount, page, buffer, size);
+        wait(operations, dataCount);
+        if(status != EEPROM_Status_Sucess) {
+            return status;
+        }
+        auto failed = dataCount;
+        for(uint8_t i = 0; i < dataCount; ++i) {
+            if(operations[i].status == EEPROM_Status_Sucess) {
+                continue;
+            }
+            if(failed != dataCount) {
+                // Single parity can't rebuild two parts
+                return operations[i].status;
+            }
+            failed = i;
+        }
+        if(failed == dataCount) {
+            return EEPROM_Status_Sucess;
+        }
+        return rebuild(operations[failed], dataDevices[failed], parityDevice, page, buffer, size, partSize);
+    }
+
+    auto getPagesCount(uint16_t size) const -> uint16_t {
+        if(!isInitialized()) {
+            return 0;
+        }
+        // Part pages plus the CRC page, the layout of EEPROM_getBuffersPagesCount()
+        return getPartSize(size) / mPageSize + 2;
+    }
+
+    auto getRebuiltCount() const {
+        return mRebuiltCount;
+    }
+
+private:
+
+    auto rebuild(EEPROM_Operation& failedOperation, uint8_t failedDevice, uint8_t parityDevice, 
+                 uint16_t page, uint8_t* buffer, uint16_t size, uint16_t partSize) -> EEPROM_Status {
+        EEPROM_Operation parityOperation{};
+        auto status = EEPROM_ReadDeviceAsync(parityDevice, &parityOperation, page, mParity, partSize);
+        if(status != EEPROM_Status_Sucess) {
+            return status;
+        }
+        wait(&parityOperation, 1);
+        if(parityOperation.status != EEPROM_Status_Sucess) {
+            return failedOperation.status;
+        }
+        // parity ^ all good parts leaves the missing one in mParity
+        uint16_t failedOffset = failedOperation.bytes - buffer;
+        for(uint16_t offset = 0; offset < size; offset += partSize) {
+            if(offset != failedOffset) {
+                xorPart(buffer + offset, getPartLength(offset, size, partSize), mParity);
+            }
+        }
+        auto failedLength = getPartLength(failedOffset, size, partSize);
+        for(uint16_t i = 0; i < failedLength; ++i) {
+            buffer[failedOffset + i] = mParity[i];
+        }
+        ++mRebuiltCount;
+        // Repair the bad copy, the record is already valid for the caller
+        EEPROM_Operation repairOperation{};
+        if(EEPROM_WriteDeviceAsync(failedDevice, &repairOperation, page, buffer + failedOffset, failedLength) == EEPROM_Status_Sucess) {
+            wait(&repairOperation, 1);
+        }
+        return EEPROM_Status_Sucess;
+    }
+
+    // Returns the parity device, data parts follow it in the device ring
+    auto mapDevices(uint16_t page, uint8_t* dataDevices) const -> uint8_t {
+        auto parityIndex = page % mCount;
+        for(uint8_t i = 0; i < mCount - 1; ++i) {
+            dataDevices[i] = mDevices[(parityIndex + 1 + i) % mCount];
+        }
+        return mDevices[parityIndex];
+    }
+
+    static void calcParity(const uint8_t* buffer, uint16_t size, uint16_t partSize, uint8_t* parity) {
+        for(uint16_t i = 0; i < partSize; ++i) {
+            parity[i] = 0;
+        }
+        for(uint16_t offset = 0; offset < size; offset += partSize) {
+            xorPart(buffer + offset, getPartLength(offset, size, partSize), parity);
+        }
+    }
+
+    static void xorPart(const uint8_t* part, uint16_t length, uint8_t* parity) {
+        for(uint16_t i = 0; i < length; ++i) {
+            parity[i] ^= part[i];
+        }
+    }
+
+    static auto getPartLength(uint16_t offset, uint16_t size, uint16_t partSize) -> uint16_t {
+        if(offset >= size) {
+            return 0;
+        }
+        auto remain = static_cast<uint16_t>(size - offset);
+        return remain > partSize ? partSize : remain;
+    }
+
+    auto getPartSize(uint16_t size) const -> uint16_t {
+        return EEPROM_getSplitPartSize(size, mCount - 1);
+    }
+
+    static void wait(const EEPROM_Operation* operations, uint8_t count) {
+        while(EEPROM_getGroupStatus(operations, count) == EEPROM_Status_Pending) {
+            EEPROM_Step();
+        }
+    }
+
+    uint8_t mDevices[EEPROM_MAX_DEVICES]{};
+    uint8_t mCount{};
+    uint16_t mPageSize{};
+    uint32_t mRebuiltCount{};
+    uint8_t mParity[EEPROM_PARITY_MAX_PART_SIZE]{};
+};
+
+static auto sParity = Parity{};
+
+EEPROM_Status EEPROM_Parity_Init(const uint8_t* devices, uint8_t count) {
+    return sParity.init(devices, count);
+}
+
+EEPROM_Status EEPROM_Parity_Read(uint16_t page, uint8_t* bytes, uint16_t size) {
+    return sParity.read(page, bytes, size);
+}
+
+EEPROM_Status EEPROM_Parity_Write(uint16_t page, uint8_t* bytes, uint16_t size) {
+    return sParity.write(page, bytes, size);
+}
+
+uint16_t EEPROM_Parity_getPagesCount(uint16_t size) {
+    return sParity.getPagesCount(size);
+}
+
+uint32_t EEPROM_Parity_getRebuiltCount(void) {
+    return sParity.getRebuiltCount();
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include "EEPROM.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Largest part of a record stored on one device, the parity buffer size
+#ifndef EEPROM_PARITY_MAX_PART_SIZE
+#define EEPROM_PARITY_MAX_PART_SIZE 256
+#endif
+
+// Striped record over 3 or more distinct devices initialized with EEPROM_InitDevice().
+// Every record is split between count - 1 devices plus an XOR parity part,
+// the parity device rotates with the page number. Each part keeps its own CRC,
+// so one missing or corrupt part is rebuilt from the others on read.
+EEPROM_Status EEPROM_Parity_Init(const uint8_t* devices, uint8_t count);
+EEPROM_Status EEPROM_Parity_Read(uint16_t page, uint8_t* bytes, uint16_t size);
+EEPROM_Status EEPROM_Parity_Write(uint16_t page, uint8_t* bytes, uint16_t size);
+// Pages used by the record on every device, including the CRC page
+uint16_t EEPROM_Parity_getPagesCount(uint16_t size);
+uint32_t EEPROM_Parity_getRebuiltCount(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,220 @@
+#include "EEPROM_Power.h"
+
+class Power {
+    static constexpr auto sRetryDelay = 100u;
+    // Device address and two memory address bytes, the read repeats the device address
+    static constexpr auto sWriteOverhead = 3u;
+    static constexpr auto sReadOverhead = 4u;
+    static constexpr auto sBitsPerByte = 9u;
+
+    enum EntryState : uint8_t {
+        EntryState_Free,
+        EntryState_Deferred,
+        EntryState_Flushing
+    };
+
+    struct Entry {
+        EEPROM_Operation operation;
+        uint8_t* bytes;
+        uint32_t deadline;
+        uint16_t page;
+        uint16_t size;
+        uint8_t device;
+        EntryState state;
+        // Changed while its write was in flight, written again once that one completes
+        bool isDirty;
+    };
+
+public:
+    auto init(const EEPROM_PowerProfile& profile) {
+        if(profile.busSpeedHz == 0 || profile.supplyMillivolts == 0) {
+            return EEPROM_Status_NotInitialized;
+        }
+        mProfile = profile;
+        EEPROM_setSleepOnWait(profile.sleepOnWait);
+        mTask.run = [](void* context) { static_cast<Power*>(context)->step(); };
+        mTask.context = this;
+        EEPROM_addBackgroundTask(&mTask);
+        return EEPROM_Status_Sucess;
+    }
+
+    auto isInitialized() const {
+        return mProfile.busSpeedHz != 0;
+    }
+
+    auto writeDeferred(uint8_t device, uint16_t page, uint8_t* bytes, uint16_t size, uint32_t maxStaleness) {
+        if(!isInitialized() || EEPROM_getDevicePageSize(device) == 0) {
+            return EEPROM_Status_NotInitialized;
+        }
+        auto deadline = HAL_GetTick() + maxStaleness;
+        Entry* freeEntry = nullptr;
+        for(auto& entry : mEntries) {
+            // One entry per record, so two writes of it are never queued at once
+            if(entry.state != EntryState_Free && entry.device == device && entry.page == page) {
+                entry.bytes = bytes;
+                entry.size = size;
+                entry.isDirty = entry.state == EntryState_Flushing;
+                if(isDue(entry.deadline, deadline)) {
+                    entry.deadline = deadline;
+                }
+                ++mReport.coalescedWrites;
+                return EEPROM_Status_Sucess;
+            }
+            if(freeEntry == nullptr && entry.state == EntryState_Free) {
+                freeEntry = &entry;
+            }
+        }
+        if(freeEntry == nullptr) {
+            return EEPROM_Status_Busy;
+        }
+        freeEntry->bytes = bytes;
+        freeEntry->deadline = deadline;
+        freeEntry->page = page;
+        freeEntry->size = size;
+        freeEntry->device = device;
+        freeEntry->state = EntryState_Deferred;
+        freeEntry->isDirty = false;
+        ++mReport.deferredWrites;
+        return EEPROM_Status_Sucess;
+    }
+
+    auto flush() {
+        if(!isInitialized()) {
+            return EEPROM_Status_NotInitialized;
+        }
+        // Entries already in flight are waited for, a record changed meanwhile goes out in the second round
+        for(auto round = 0; round < 2 && (hasEntries(EntryState_Deferred) || hasEntries(EntryState_Flushing)); ++round) {
+            startBurst();
+            while(hasEntries(EntryState_Flushing)) {
+                EEPROM_Step();
+                if(mProfile.sleepOnWait && hasEntries(EntryState_Flushing)) {
+                    // I2C interrupts and SysTick wake the core for the next step
+                    __WFI();
+                }
+            }
+        }
+        return hasEntries(EntryState_Deferred) ? EEPROM_Status_Error : EEPROM_Status_Sucess;
+    }
+
+    auto getDeferredCount() const {
+        uint8_t count = 0;
+        for(auto& entry : mEntries) {
+            count += entry.state != EntryState_Free;
+        }
+        return count;
+    }
+
+    // Bus transfer and write cycle time of a record with its CRC page, in nanojoules
+    auto estimateEnergy(uint8_t device, bool isWrite, uint16_t size) const -> uint32_t {
+        auto pageSize = EEPROM_getDevicePageSize(device);
+        if(!isInitialized() || pageSize == 0) {
+            return 0;
+        }
+        uint64_t transfers = (size + pageSize - 1) / pageSize + 1;
+        uint64_t busBytes = size + sizeof(uint32_t) + transfers * (isWrite ? sWriteOverhead : sReadOverhead);
+        uint64_t busMicroseconds = busBytes * sBitsPerByte * 1000000u / mProfile.busSpeedHz;
+        uint64_t waitMicroseconds = isWrite ? transfers * mProfile.writeCycleMicroseconds : 0;
+        auto waitMicroamps = mProfile.sleepOnWait ? mProfile.sleepMicroamps : mProfile.activeMicroamps;
+        uint64_t charge = mProfile.activeMicroamps * busMicroseconds + 
+                          (waitMicroamps + mProfile.writeCycleMicroamps) * waitMicroseconds;
+        // mV * uA * us = fJ
+        return static_cast<uint32_t>(charge * mProfile.supplyMillivolts / 1000000u);
+    }
+
+    auto getReport() const {
+        return mReport;
+    }
+
+private:
+
+    void step() {
+        for(auto& entry : mEntries) {
+            if(entry.state != EntryState_Flushing || entry.operation.status == EEPROM_Status_Pending) {
+                continue;
+            }
+            if(entry.operation.status != EEPROM_Status_Sucess) {
+                ++mReport.failedWrites;
+                entry.deadline = HAL_GetTick() + sRetryDelay;
+                entry.state = EntryState_Deferred;
+                entry.isDirty = false;
+                continue;
+            }
+            mReport.lastOperationNanojoules = estimateEnergy(entry.device, true, entry.size);
+            mReport.totalNanojoules += mReport.lastOperationNanojoules;
+            // The stored copy may mix the old and the new contents, the rewrite keeps the deadline
+            entry.state = entry.isDirty ? EntryState_Deferred : EntryState_Free;
+            entry.isDirty = false;
+        }
+        auto now = HAL_GetTick();
+        for(auto& entry : mEntries) {
+            if(entry.state == EntryState_Deferred && isDue(now, entry.deadline)) {
+                startBurst();
+                break;
+            }
+        }
+    }
+
+    // Everything deferred goes out together, the core wakes once per burst instead of once per record
+    void startBurst() {
+        auto started = false;
+        for(auto& entry : mEntries) {
+            if(entry.state != EntryState_Deferred) {
+                continue;
+            }
+            if(EEPROM_WriteDeviceAsync(entry.device, &entry.operation, entry.page, entry.bytes, entry.size) != EEPROM_Status_Sucess) {
+                continue;
+            }
+            entry.state = EntryState_Flushing;
+            started = true;
+        }
+        mReport.bursts += started;
+    }
+
+    auto hasEntries(EntryState state) const -> bool {
+        for(auto& entry : mEntries) {
+            if(entry.state == state) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static auto isDue(uint32_t now, uint32_t deadline) -> bool {
+        return static_cast<int32_t>(now - deadline) >= 0;
+    }
+
+    EEPROM_PowerProfile mProfile{};
+    EEPROM_PowerReport mReport{};
+    Entry mEntries[EEPROM_POWER_MAX_DEFERRED]{};
+    EEPROM_BackgroundTask mTask{};
+};
+
+static auto sPower = Power{};
+
+EEPROM_PowerProfile EEPROM_Power_makeDefaultProfile(void) {
+    return EEPROM_PowerProfile{3300, 5000, 400000, 10000, 2000, 3000, 1};
+}
+
+EEPROM_Status EEPROM_Power_Init(EEPROM_PowerProfile profile) {
+    return sPower.init(profile);
+}
+
+EEPROM_Status EEPROM_Power_WriteDeferred(uint8_t device, uint16_t page, uint8_t* bytes, uint16_t size, uint32_t maxStalenessMs) {
+    return sPower.writeDeferred(device, page, bytes, size, maxStalenessMs);
+}
+
+EEPROM_Status EEPROM_Power_Flush(void) {
+    return sPower.flush();
+}
+
+uint8_t EEPROM_Power_getDeferredCount(void) {
+    return sPower.getDeferredCount();
+}
+
+uint32_t EEPROM_Power_estimateEnergy(uint8_t device, uint8_t isWrite, uint16_t size) {
+    return sPower.estimateEnergy(device, isWrite != 0, size);
+}
+
+EEPROM_PowerReport EEPROM_Power_getReport(void) {
+    return sPower.getReport();
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include "EEPROM.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef EEPROM_POWER_MAX_DEFERRED
+#define EEPROM_POWER_MAX_DEFERRED 8
+#endif
+
+// Figures used for the energy estimation, currents are averages over the phase
+typedef struct {
+  uint16_t supplyMillivolts;
+  uint16_t writeCycleMicroseconds;
+  uint32_t busSpeedHz;
+  uint32_t activeMicroamps;
+  uint32_t sleepMicroamps;
+  uint32_t writeCycleMicroamps;
+  uint8_t sleepOnWait;
+} EEPROM_PowerProfile;
+
+typedef struct {
+  uint32_t deferredWrites;
+  uint32_t coalescedWrites;
+  uint32_t bursts;
+  uint32_t failedWrites;
+  uint32_t lastOperationNanojoules;
+  uint64_t totalNanojoules;
+} EEPROM_PowerReport;
+
+EEPROM_PowerProfile EEPROM_Power_makeDefaultProfile(void);
+EEPROM_Status EEPROM_Power_Init(EEPROM_PowerProfile profile);
+// Stores the record not later than maxStalenessMs from now. All deferred
+// records are written in one burst once the first of them is due. The buffer
+// must stay valid until the record is flushed, a newer write of the same
+// record replaces the older one. A record changed while its write is in flight
+// is written again once that write completes.
+EEPROM_Status EEPROM_Power_WriteDeferred(uint8_t device, uint16_t page, uint8_t* bytes, uint16_t size, uint32_t maxStalenessMs);
+// Writes all deferred records now and waits for them, sleeping between steps
+EEPROM_Status EEPROM_Power_Flush(void);
+uint8_t EEPROM_Power_getDeferredCount(void);
+uint32_t EEPROM_Power_estimateEnergy(uint8_t device, uint8_t isWrite, uint16_t size);
+EEPROM_PowerReport EEPROM_Power_getReport(void);
+
+#ifdef __cplusplus
+}
+#endif
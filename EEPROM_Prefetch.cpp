@@ -0,0 +1,264 @@
+#include "EEPROM_Prefetch.h"
+
+// Two buffers over the byte addresses of the device: the current one serves the
+// reads, the other one holds the following window. Writes of the driver drop the
+// buffers they overlap.
+class Prefetch {
+    struct Buffer {
+        alignas(4) uint8_t bytes[EEPROM_PREFETCH_BUFFER_SIZE];
+        uint32_t start;
+        uint16_t size;
+        EEPROM_Operation operation;
+    };
+
+    static constexpr uint32_t sAddressSpace = 0x10000;
+
+public:
+    auto init(const EEPROM_PrefetchConfig& config) -> EEPROM_Status {
+        auto pageSize = EEPROM_getDevicePageSize(config.device);
+        if(config.hCRC == nullptr || pageSize == 0) {
+            return EEPROM_Status_NotInitialized;
+        }
+        invalidate();
+        mNextAddress = UINT32_MAX;
+        mConfig = config;
+        mPageSize = pageSize;
+        mWindow = pageSize < EEPROM_PREFETCH_BUFFER_SIZE ? pageSize : EEPROM_PREFETCH_BUFFER_SIZE;
+        mReport = EEPROM_PrefetchReport{};
+        mObserver.onWrite = [](void* context, uint8_t device, uint16_t page, uint16_t lastPage) {
+            static_cast<Prefetch*>(context)->forgetWritten(device, page, lastPage);
+        };
+        mObserver.context = this;
+        EEPROM_addWriteObserver(&mObserver);
+        return EEPROM_Status_Sucess;
+    }
+
+    auto read(uint16_t page, uint8_t* bytes, uint16_t size, bool useCRC) -> EEPROM_Status {
+        if(mPageSize == 0) {
+            return EEPROM_Status_NotInitialized;
+        }
+        uint32_t address = page * mPageSize;
+        if(!useCRC) {
+            return readBytes(address, bytes, size);
+        }
+        auto pages = static_cast<uint32_t>(size / mPageSize + 1);
+        uint32_t crc{};
+        auto status = readBytes(address, bytes, size);
+        if(status == EEPROM_Status_Sucess) {
+            status = readBytes((page + pages) * mPageSize, reinterpret_cast<uint8_t*>(&crc), sizeof(crc));
+        }
+        if(status != EEPROM_Status_Sucess) {
+            return status;
+        }
+        if(crc != HAL_CRC_Calculate(mConfig.hCRC, reinterpret_cast<uint32_t*>(bytes), size / 4)) {
+            return EEPROM_Status_InvalidCRC;
+        }
+        return EEPROM_Status_Sucess;
+    }
+
+    // A read ahead in flight is waited for, its buffer can't be reused before
+    void invalidate() {
+        for(auto& buffer : mBuffers) {
+            wait(buffer);
+            if(buffer.size != 0 && &buffer != &mBuffers[mCurrent]) {
+                ++mReport.wasted;
+                shrinkWindow();
+            }
+            buffer.size = 0;
+        }
+        mIsSequential = false;
+    }
+
+    auto getReport() -> EEPROM_PrefetchReport {
+        mReport.window = mWindow;
+        return mReport;
+    }
+
+private:
+    // Records of a scan are a few bytes apart: the rest of the last page and the CRC word
+    auto readBytes(uint32_t address, uint8_t* bytes, uint16_t size) -> EEPROM_Status {
+        auto isSequential = (address >= mNextAddress && address - mNextAddress <= mPageSize) || 
+                            contains(mBuffers[0], address) || contains(mBuffers[1], address);
+        mNextAddress = address + size;
+        while(size > 0) {
+            auto& current = mBuffers[mCurrent];
+            auto& next = mBuffers[mCurrent ^ 1];
+            uint16_t copied{};
+            if(contains(current, address)) {
+                copied = copy(current, address, bytes, size);
+                ++mReport.hits;
+            } else if(wait(next) == EEPROM_Status_Sucess && contains(next, address)) {
+                // The read ahead was used, the next one may be larger
+                current.size = 0;
+                mCurrent ^= 1;
+                growWindow();
+                continue;
+            } else if(isSequential && size < EEPROM_PREFETCH_BUFFER_SIZE) {
+                // The scan overtook the read ahead, a larger window would have kept up
+                ++mReport.misses;
+                growWindow();
+                dropReadAhead(next);
+                auto status = fill(current, address, size > mWindow ? size : mWindow);
+                if(status != EEPROM_Status_Sucess) {
+                    return status;
+                }
+                continue;
+            } else {
+                // Random access bypasses the buffers
+                ++mReport.misses;
+                mIsSequential = false;
+                return readDirect(address, bytes, size);
+            }
+            address += copied;
+            bytes += copied;
+            size -= copied;
+        }
+        mIsSequential = isSequential;
+        // Nothing stays queued once the call returns, a failed read ahead only leaves the buffer empty
+        startReadAhead();
+        wait(mBuffers[mCurrent ^ 1]);
+        return EEPROM_Status_Sucess;
+    }
+
+    // Called as the write is submitted, a read ahead still in flight is dropped once it completes
+    void forgetWritten(uint8_t device, uint16_t page, uint16_t lastPage) {
+        if(device != mConfig.device || mPageSize == 0) {
+            return;
+        }
+        uint32_t first = page * mPageSize;
+        uint32_t end = (lastPage + 1u) * mPageSize;
+        for(auto& buffer : mBuffers) {
+            if(buffer.size == 0 || buffer.start >= end || first >= buffer.start + buffer.size) {
+                continue;
+            }
+            if(&buffer != &mBuffers[mCurrent]) {
+                ++mReport.wasted;
+                shrinkWindow();
+            }
+            buffer.size = 0;
+        }
+    }
+
+    // The following window, in one transfer
+    void startReadAhead() {
+        auto& current = mBuffers[mCurrent];
+        auto& next = mBuffers[mCurrent ^ 1];
+        if(!mIsSequential || current.size == 0 || next.operation.status == EEPROM_Status_Pending || next.size != 0) {
+            return;
+        }
+        auto end = current.start + current.size;
+        if(end >= sAddressSpace) {
+            return;
+        }
+        if(submit(next, end, mWindow) == EEPROM_Status_Sucess) {
+            ++mReport.prefetches;
+        }
+    }
+
+    auto fill(Buffer& buffer, uint32_t address, uint16_t size) -> EEPROM_Status {
+        auto status = submit(buffer, address, size);
+        if(status != EEPROM_Status_Sucess) {
+            return status;
+        }
+        return wait(buffer);
+    }
+
+    auto submit(Buffer& buffer, uint32_t address, uint16_t size) -> EEPROM_Status {
+        if(address + size > sAddressSpace) {
+            size = static_cast<uint16_t>(sAddressSpace - address);
+        }
+        buffer.start = address;
+        buffer.size = size;
+        auto status = EEPROM_ReadDeviceBytesAsync(mConfig.device, &buffer.operation, static_cast<uint16_t>(address), 
+                                                  buffer.bytes, size);
+        if(status != EEPROM_Status_Sucess) {
+            buffer.size = 0;
+        }
+        return status;
+    }
+
+    auto wait(Buffer& buffer) -> EEPROM_Status {
+        while(buffer.operation.status == EEPROM_Status_Pending) {
+            EEPROM_Step();
+        }
+        if(buffer.operation.status != EEPROM_Status_Sucess) {
+            buffer.size = 0;
+        }
+        return buffer.operation.status;
+    }
+
+    void dropReadAhead(Buffer& buffer) {
+        wait(buffer);
+        if(buffer.size != 0) {
+            buffer.size = 0;
+            ++mReport.wasted;
+            shrinkWindow();
+        }
+    }
+
+    auto readDirect(uint32_t address, uint8_t* bytes, uint16_t size) const -> EEPROM_Status {
+        EEPROM_Operation operation{};
+        auto status = EEPROM_ReadDeviceBytesAsync(mConfig.device, &operation, static_cast<uint16_t>(address), bytes, size);
+        if(status != EEPROM_Status_Sucess) {
+            return status;
+        }
+        while(operation.status == EEPROM_Status_Pending) {
+            EEPROM_Step();
+        }
+        return operation.status;
+    }
+
+    static auto contains(const Buffer& buffer, uint32_t address) -> bool {
+        return buffer.operation.status != EEPROM_Status_Pending && address >= buffer.start && 
+               address < buffer.start + buffer.size;
+    }
+
+    static auto copy(const Buffer& buffer, uint32_t address, uint8_t* bytes, uint16_t size) -> uint16_t {
+        auto offset = address - buffer.start;
+        auto count = buffer.size - offset < size ? static_cast<uint16_t>(buffer.size - offset) : size;
+        for(uint16_t i = 0; i < count; ++i) {
+            bytes[i] = buffer.bytes[offset + i];
+        }
+        return count;
+    }
+
+    void growWindow() {
+        mWindow = mWindow * 2 < EEPROM_PREFETCH_BUFFER_SIZE ? mWindow * 2 : EEPROM_PREFETCH_BUFFER_SIZE;
+    }
+
+    void shrinkWindow() {
+        mWindow = mWindow / 2 > mPageSize ? mWindow / 2 : (mPageSize < EEPROM_PREFETCH_BUFFER_SIZE ? mPageSize : mWindow);
+    }
+
+    EEPROM_PrefetchConfig mConfig{};
+    uint16_t mPageSize{};
+    uint16_t mWindow{};
+    Buffer mBuffers[2]{};
+    uint8_t mCurrent{};
+    uint32_t mNextAddress{UINT32_MAX};
+    bool mIsSequential{};
+    EEPROM_PrefetchReport mReport{};
+    EEPROM_WriteObserver mObserver{};
+};
+
+static auto sPrefetch = Prefetch{};
+
+EEPROM_Status EEPROM_Prefetch_Init(EEPROM_PrefetchConfig config) {
+    return sPrefetch.init(config);
+}
+
+EEPROM_Status EEPROM_Prefetch_Read(uint16_t page, uint8_t* bytes, uint16_t size) {
+    return sPrefetch.read(page, bytes, size, true);
+}
+
+EEPROM_Status EEPROM_Prefetch_ReadRaw(uint16_t page, uint8_t* bytes, uint16_t size) {
+    return sPrefetch.read(page, bytes, size, false);
+}
+
+void EEPROM_Prefetch_Invalidate(void) {
+    sPrefetch.invalidate();
+}
+
+EEPROM_PrefetchReport EEPROM_Prefetch_getReport(void) {
+    return sPrefetch.getReport();
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include "EEPROM.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Each of the two buffers, the largest window read ahead in one transfer
+#ifndef EEPROM_PREFETCH_BUFFER_SIZE
+#define EEPROM_PREFETCH_BUFFER_SIZE 256
+#endif
+
+typedef struct {
+  CRC_HandleTypeDef* hCRC;
+  uint8_t device;
+} EEPROM_PrefetchConfig;
+
+typedef struct {
+  uint32_t hits;
+  uint32_t misses;
+  uint32_t prefetches;
+  // Read ahead and dropped unused, by a jump or an invalidation
+  uint32_t wasted;
+  uint16_t window;
+} EEPROM_PrefetchReport;
+
+EEPROM_Status EEPROM_Prefetch_Init(EEPROM_PrefetchConfig config);
+// Same record layout as EEPROM_ReadDevice(), bytes must be word aligned.
+// Once reads go through the pages in order, the next window is read ahead in one
+// transfer before the call returns, so no operation stays queued. The window doubles
+// while the read ahead bytes get used and halves when they are dropped. Writes of the
+// driver drop the buffers they overlap.
+EEPROM_Status EEPROM_Prefetch_Read(uint16_t page, uint8_t* bytes, uint16_t size);
+EEPROM_Status EEPROM_Prefetch_ReadRaw(uint16_t page, uint8_t* bytes, uint16_t size);
+// Drops both buffers, a read ahead in flight is waited for
+void EEPROM_Prefetch_Invalidate(void);
+EEPROM_PrefetchReport EEPROM_Prefetch_getReport(void);
+
+#ifdef __cplusplus
+}
+#endif
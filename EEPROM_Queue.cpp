@@ -0,0 +1,140 @@
+#include "EEPROM_Queue.h"
+#include <atomic>
+
+static_assert((EEPROM_QUEUE_SIZE & (EEPROM_QUEUE_SIZE - 1)) == 0, "EEPROM_QUEUE_SIZE must be a power of two");
+static_assert(EEPROM_QUEUE_PAYLOAD_SIZE % 4 == 0, "EEPROM_QUEUE_PAYLOAD_SIZE must be a multiple of 4");
+
+// Bounded multi-producer queue after Dmitry Vyukov: the sequence of a cell tells
+// whether it is free for the producer at that position or filled for the consumer.
+// The consumer is the background task only, it keeps a cell until its write completed.
+class Queue {
+    static constexpr uint32_t sMask = EEPROM_QUEUE_SIZE - 1;
+
+    struct Cell {
+        std::atomic<uint32_t> sequence;
+        EEPROM_Operation operation;
+        uint16_t page;
+        uint16_t size;
+        uint8_t device;
+        alignas(uint32_t) uint8_t payload[EEPROM_QUEUE_PAYLOAD_SIZE];
+    };
+
+public:
+    auto init() -> EEPROM_Status {
+        if(mSubmitPosition != mDequeuePosition) {
+            return EEPROM_Status_Busy;
+        }
+        for(uint32_t i = 0; i < EEPROM_QUEUE_SIZE; ++i) {
+            mCells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        mEnqueuePosition.store(0, std::memory_order_relaxed);
+        mDequeuePosition = 0;
+        mSubmitPosition = 0;
+        mTask.run = [](void* context) { static_cast<Queue*>(context)->step(); };
+        mTask.context = this;
+        EEPROM_addBackgroundTask(&mTask);
+        mIsInitialized.store(true, std::memory_order_release);
+        return EEPROM_Status_Sucess;
+    }
+
+    auto enqueue(uint8_t device, uint16_t page, const uint8_t* bytes, uint16_t size) -> EEPROM_Status {
+        if(!mIsInitialized.load(std::memory_order_acquire)) {
+            return EEPROM_Status_NotInitialized;
+        }
+        if(size > EEPROM_QUEUE_PAYLOAD_SIZE || size % 4 != 0) {
+            return EEPROM_Status_Error;
+        }
+        auto position = mEnqueuePosition.load(std::memory_order_relaxed);
+        Cell* cell;
+        for(;;) {
+            cell = &mCells[position & sMask];
+            auto sequence = cell->sequence.load(std::memory_order_acquire);
+            auto difference = static_cast<int32_t>(sequence - position);
+            if(difference == 0) {
+                // A preempting producer may take the position first, the loop moves on then
+                if(mEnqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if(difference < 0) {
+                mDropped.fetch_add(1, std::memory_order_relaxed);
+                return EEPROM_Status_Busy;
+            } else {
+                position = mEnqueuePosition.load(std::memory_order_relaxed);
+            }
+        }
+        cell->device = device;
+        cell->page = page;
+        cell->size = size;
+        for(uint16_t i = 0; i < size; ++i) {
+            cell->payload[i] = bytes[i];
+        }
+        cell->sequence.store(position + 1, std::memory_order_release);
+        return EEPROM_Status_Sucess;
+    }
+
+    auto isEmpty() const -> bool {
+        return mEnqueuePosition.load(std::memory_order_acquire) == mDequeuePosition;
+    }
+
+    auto getReport() const {
+        return EEPROM_QueueReport{mEnqueuePosition.load(std::memory_order_relaxed), mDropped.load(std::memory_order_relaxed), mWritten, mFailed};
+    }
+
+private:
+
+    // Completed writes free their cells in order, then the next filled cells go to the driver together
+    void step() {
+        while(mDequeuePosition != mSubmitPosition) {
+            auto& cell = mCells[mDequeuePosition & sMask];
+            if(cell.operation.status == EEPROM_Status_Pending) {
+                break;
+            }
+            if(cell.operation.status == EEPROM_Status_Sucess) {
+                ++mWritten;
+            } else {
+                ++mFailed;
+            }
+            cell.sequence.store(mDequeuePosition + EEPROM_QUEUE_SIZE, std::memory_order_release);
+            ++mDequeuePosition;
+        }
+        while(mSubmitPosition - mDequeuePosition < EEPROM_QUEUE_BATCH) {
+            auto& cell = mCells[mSubmitPosition & sMask];
+            if(cell.sequence.load(std::memory_order_acquire) != mSubmitPosition + 1) {
+                break;
+            }
+            cell.operation = EEPROM_Operation{};
+            if(EEPROM_WriteDeviceAsync(cell.device, &cell.operation, cell.page, cell.payload, cell.size) != EEPROM_Status_Sucess) {
+                cell.operation.status = EEPROM_Status_NotInitialized;
+            }
+            ++mSubmitPosition;
+        }
+    }
+
+    Cell mCells[EEPROM_QUEUE_SIZE]{};
+    std::atomic<uint32_t> mEnqueuePosition{};
+    std::atomic<uint32_t> mDropped{};
+    std::atomic<bool> mIsInitialized{};
+    uint32_t mDequeuePosition{};
+    uint32_t mSubmitPosition{};
+    uint32_t mWritten{};
+    uint32_t mFailed{};
+    EEPROM_BackgroundTask mTask{};
+};
+
+static auto sQueue = Queue{};
+
+EEPROM_Status EEPROM_Queue_Init(void) {
+    return sQueue.init();
+}
+
+EEPROM_Status EEPROM_Queue_WriteFromISR(uint8_t device, uint16_t page, const uint8_t* bytes, uint16_t size) {
+    return sQueue.enqueue(device, page, bytes, size);
+}
+
+uint8_t EEPROM_Queue_isEmpty(void) {
+    return sQueue.isEmpty();
+}
+
+EEPROM_QueueReport EEPROM_Queue_getReport(void) {
+    return sQueue.getReport();
+}
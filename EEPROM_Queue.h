@@ -0,0 +1,40 @@
+#pragma once
+#include "EEPROM.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Request descriptors, a power of two
+#ifndef EEPROM_QUEUE_SIZE
+#define EEPROM_QUEUE_SIZE 8
+#endif
+
+// Record bytes carried inline by a descriptor, a multiple of 4
+#ifndef EEPROM_QUEUE_PAYLOAD_SIZE
+#define EEPROM_QUEUE_PAYLOAD_SIZE 32
+#endif
+
+// Requests handed to the driver at once by one EEPROM_Step()
+#ifndef EEPROM_QUEUE_BATCH
+#define EEPROM_QUEUE_BATCH 4
+#endif
+
+typedef struct {
+  uint32_t queued;
+  uint32_t dropped;
+  uint32_t written;
+  uint32_t failed;
+} EEPROM_QueueReport;
+
+EEPROM_Status EEPROM_Queue_Init(void);
+// Callable from any interrupt and from thread context: copies the record into a
+// free descriptor without locks, waits and driver calls. EEPROM_Step() writes it
+// with its CRC. Busy when every descriptor is taken, the request is dropped then.
+EEPROM_Status EEPROM_Queue_WriteFromISR(uint8_t device, uint16_t page, const uint8_t* bytes, uint16_t size);
+uint8_t EEPROM_Queue_isEmpty(void);
+EEPROM_QueueReport EEPROM_Queue_getReport(void);
+
+#ifdef __cplusplus
+}
+#endif
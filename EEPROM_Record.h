@@ -0,0 +1,123 @@
+#pragma once
+// C++ interface to one record of a struct type: fields are changed one at a
+// time and only their bytes and the CRC word go to the EEPROM.
+#include "EEPROM.h"
+
+#ifdef __cplusplus
+#include <string.h>
+#include <type_traits>
+
+namespace eeprom {
+
+// Keeps a copy of the record in RAM, the CRC of an update is computed from it.
+// Same layout as EEPROM_ReadDevice()/EEPROM_WriteDevice(). Blocking calls.
+template<typename T>
+class Record {
+    static_assert(std::is_trivially_copyable<T>::value, "The record is stored as raw bytes");
+    static_assert(sizeof(T) % 4 == 0, "The CRC unit works with 32-bit words");
+
+public:
+    Record(CRC_HandleTypeDef* hCRC, uint8_t device, uint16_t page) : mCRC(hCRC), mDevice(device), mPage(page) {
+    }
+
+    auto load() -> EEPROM_Status {
+        auto status = EEPROM_ReadDevice(mDevice, mPage, getBytes(), sizeof(T));
+        mIsLoaded = status == EEPROM_Status_Sucess;
+        return status;
+    }
+
+    auto store(const T& value) -> EEPROM_Status {
+        memcpy(&mValue, &value, sizeof(T));
+        auto status = EEPROM_WriteDevice(mDevice, mPage, getBytes(), sizeof(T));
+        mIsLoaded = status == EEPROM_Status_Sucess;
+        return status;
+    }
+
+    auto get() const -> const T& {
+        return mValue;
+    }
+
+    template<typename F>
+    auto get(F T::*field) const -> const F& {
+        return mValue.*field;
+    }
+
+    // Writes the bytes of the field that differ and the new CRC word. A reset
+    // in between leaves a record with a bad CRC, like a torn EEPROM_WriteDevice().
+    template<typename F>
+    auto set(F T::*field, const F& value) -> EEPROM_Status {
+        static_assert(std::is_trivially_copyable<F>::value, "The field is stored as raw bytes");
+        if(!mIsLoaded) {
+            return EEPROM_Status_NotInitialized;
+        }
+        auto offset = static_cast<uint16_t>(reinterpret_cast<const uint8_t*>(&(mValue.*field)) - getBytes());
+        auto current = getBytes() + offset;
+        auto next = reinterpret_cast<const uint8_t*>(&value);
+        uint16_t first = 0;
+        uint16_t end = sizeof(F);
+        while(first < end && current[first] == next[first]) {
+            ++first;
+        }
+        while(end > first && current[end - 1] == next[end - 1]) {
+            --end;
+        }
+        if(first == end) {
+            return EEPROM_Status_Sucess;
+        }
+        F previous;
+        memcpy(&previous, current, sizeof(F));
+        memcpy(current, next, sizeof(F));
+        mCRCWord = HAL_CRC_Calculate(mCRC, reinterpret_cast<uint32_t*>(getBytes()), sizeof(T) / 4);
+        auto status = writeBytes(getAddress() + offset + first, current + first, end - first);
+        if(status == EEPROM_Status_Sucess) {
+            status = writeBytes(getCRCAddress(), reinterpret_cast<uint8_t*>(&mCRCWord), sizeof(mCRCWord));
+        }
+        if(status != EEPROM_Status_Sucess) {
+            // The EEPROM may hold either value now, load() tells
+            memcpy(current, &previous, sizeof(F));
+            mIsLoaded = false;
+        }
+        return status;
+    }
+
+private:
+    auto writeBytes(uint16_t address, uint8_t* bytes, uint16_t size) -> EEPROM_Status {
+        EEPROM_Operation operation{};
+        auto status = EEPROM_WriteDeviceBytesAsync(mDevice, &operation, address, bytes, size);
+        if(status != EEPROM_Status_Sucess) {
+            return status;
+        }
+        while(operation.status == EEPROM_Status_Pending) {
+            EEPROM_Step();
+        }
+        return operation.status;
+    }
+
+    auto getBytes() -> uint8_t* {
+        return reinterpret_cast<uint8_t*>(&mValue);
+    }
+
+    auto getBytes() const -> const uint8_t* {
+        return reinterpret_cast<const uint8_t*>(&mValue);
+    }
+
+    auto getAddress() const -> uint16_t {
+        return static_cast<uint16_t>(mPage * EEPROM_getDevicePageSize(mDevice));
+    }
+
+    auto getCRCAddress() const -> uint16_t {
+        auto pageSize = EEPROM_getDevicePageSize(mDevice);
+        return static_cast<uint16_t>((mPage + sizeof(T) / pageSize + 1) * pageSize);
+    }
+
+    alignas(4) T mValue{};
+    uint32_t mCRCWord{};
+    CRC_HandleTypeDef* mCRC;
+    uint8_t mDevice;
+    uint16_t mPage;
+    bool mIsLoaded{};
+};
+
+}
+
+#endif
@@ -0,0 +1,414 @@
+#include "EEPROM_Series.h"
+#include <string.h>
+
+static_assert(EEPROM_SERIES_BLOCK_SIZE % 4 == 0, "EEPROM_SERIES_BLOCK_SIZE must be a multiple of 4");
+static_assert(EEPROM_SERIES_BLOCK_SIZE <= 256, "EEPROM_SERIES_BLOCK_SIZE must fit the size of the block header");
+
+class Series {
+    struct Header {
+        uint32_t sequence;
+        // The first sample of the block
+        uint32_t timestamp;
+        int32_t value;
+        uint16_t count;
+        // Encoded bytes of the samples after the first one
+        uint8_t size;
+        // Full blocks are sealed, a flushed open block isn't
+        uint8_t isSealed;
+    };
+
+    // The CRC word takes the last 4 bytes of the page
+    struct Block {
+        Header header;
+        uint8_t data[EEPROM_SERIES_BLOCK_SIZE - sizeof(Header)];
+    };
+
+public:
+    auto init(const EEPROM_SeriesConfig& config) -> EEPROM_Status {
+        auto pageSize = EEPROM_getDevicePageSize(config.device);
+        if(config.hCRC == nullptr || pageSize == 0) {
+            return EEPROM_Status_NotInitialized;
+        }
+        if(pageSize > EEPROM_SERIES_BLOCK_SIZE || pageSize % 4 != 0 || pageSize <= sizeof(Header) + 4 || config.pageCount < 2) {
+            return EEPROM_Status_Error;
+        }
+        if(mOperation.status == EEPROM_Status_Pending) {
+            return EEPROM_Status_Busy;
+        }
+        mConfig = config;
+        mPageSize = pageSize;
+        mDataCapacity = static_cast<uint8_t>(pageSize - sizeof(Header) - 4);
+        mReport = EEPROM_SeriesReport{};
+        auto status = findHead();
+        if(status != EEPROM_Status_Sucess) {
+            mPageSize = 0;
+        }
+        return status;
+    }
+
+    auto isInitialized() const {
+        return mPageSize != 0;
+    }
+
+    auto append(uint32_t timestamp, int32_t value) -> EEPROM_Status {
+        if(!isInitialized()) {
+            return EEPROM_Status_NotInitialized;
+        }
+        if(mHasSamples && timestamp < mLastTimestamp) {
+            return EEPROM_Status_Error;
+        }
+        if(auto status = finishWrite(); status != EEPROM_Status_Sucess) {
+            return status;
+        }
+        if(mOpen.header.count == 0) {
+            openBlock(mNext, timestamp, value);
+            return EEPROM_Status_Sucess;
+        }
+        uint8_t bytes[10];
+        auto size = putVarint(bytes, timestamp - mLastTimestamp);
+        size += putVarint(bytes + size, zigzag(static_cast<uint32_t>(value) - static_cast<uint32_t>(mLastValue)));
+        if(mOpen.header.size + size <= mDataCapacity) {
+            memcpy(mOpen.data + mOpen.header.size, bytes, size);
+            mOpen.header.size += size;
+            ++mOpen.header.count;
+            mLastTimestamp = timestamp;
+            mLastValue = value;
+            ++mReport.samples;
+            return EEPROM_Status_Sucess;
+        }
+        // The sample starts the next block, it is kept in RAM until that one is written as well
+        mOpen.header.isSealed = 1;
+        prepareWrite();
+        if(auto status = submitWrite(); status != EEPROM_Status_Sucess) {
+            mOpen.header.isSealed = 0;
+            return status;
+        }
+        ++mNext;
+        openBlock(mNext, timestamp, value);
+        return EEPROM_Status_Sucess;
+    }
+
+    auto flush() -> EEPROM_Status {
+        if(!isInitialized()) {
+            return EEPROM_Status_NotInitialized;
+        }
+        if(auto status = finishWrite(); status != EEPROM_Status_Sucess) {
+            return status;
+        }
+        if(mOpen.header.count == 0) {
+            return EEPROM_Status_Sucess;
+        }
+        prepareWrite();
+        if(auto status = submitWrite(); status != EEPROM_Status_Sucess) {
+            return status;
+        }
+        return waitForWrite();
+    }
+
+    // Binary search over the first samples of the blocks, then the blocks up to the end of the window
+    auto query(uint32_t from, uint32_t to, EEPROM_SeriesSample* samples, uint16_t capacity, uint16_t& count) -> EEPROM_Status {
+        count = 0;
+        if(!isInitialized()) {
+            return EEPROM_Status_NotInitialized;
+        }
+        waitForWrite();
+        auto first = getFirstSequence();
+        auto blockCount = mNext - first;
+        uint32_t low = 0;
+        uint32_t high = blockCount;
+        Block block{};
+        while(low < high) {
+            auto middle = (low + high) / 2;
+            auto status = readSequence(first + middle, block);
+            if(status != EEPROM_Status_Sucess && status != EEPROM_Status_InvalidCRC) {
+                return status;
+            }
+            if(status == EEPROM_Status_Sucess && block.header.timestamp >= from) {
+                high = middle;
+            } else {
+                low = middle + 1;
+            }
+        }
+        // Samples equal to from may end the block before the first one starting at or after it
+        for(auto index = low > 0 ? low - 1 : 0; index < blockCount; ++index) {
+            auto status = readSequence(first + index, block);
+            if(status == EEPROM_Status_InvalidCRC) {
+                continue;
+            }
+            if(status != EEPROM_Status_Sucess) {
+                return status;
+            }
+            if(block.header.timestamp > to) {
+                return EEPROM_Status_Sucess;
+            }
+            if(!decode(block, from, to, samples, capacity, count)) {
+                return EEPROM_Status_Sucess;
+            }
+        }
+        if(mOpen.header.count != 0) {
+            decode(mOpen, from, to, samples, capacity, count);
+        }
+        return EEPROM_Status_Sucess;
+    }
+
+    auto getReport() const -> EEPROM_SeriesReport {
+        return mReport;
+    }
+
+private:
+
+    // Block i lives in page i % pageCount. The open block takes the page of the oldest one,
+    // so before the head the sequence grows by one per page and breaks at the head.
+    auto findHead() -> EEPROM_Status {
+        Block block{};
+        auto status = readBlock(0, block);
+        if(status == EEPROM_Status_InvalidCRC) {
+            // Page 0 may hold the open block after a wrap, torn or never flushed
+            status = readBlock(mConfig.pageCount - 1, block);
+            if(status == EEPROM_Status_InvalidCRC) {
+                mNext = 0;
+                mOpen = Block{};
+                mHasSamples = false;
+                return EEPROM_Status_Sucess;
+            }
+            if(status != EEPROM_Status_Sucess) {
+                return status;
+            }
+            return reopen(block);
+        }
+        if(status != EEPROM_Status_Sucess) {
+            return status;
+        }
+        auto first = block.header.sequence;
+        uint32_t low = 1;
+        uint32_t high = mConfig.pageCount;
+        while(low < high) {
+            auto middle = (low + high) / 2;
+            status = readBlock(middle, block);
+            if(status != EEPROM_Status_Sucess && status != EEPROM_Status_InvalidCRC) {
+                return status;
+            }
+            if(status == EEPROM_Status_Sucess && block.header.sequence == first + middle) {
+                low = middle + 1;
+            } else {
+                high = middle;
+            }
+        }
+        status = readBlock(low - 1, block);
+        if(status != EEPROM_Status_Sucess) {
+            return status;
+        }
+        return reopen(block);
+    }
+
+    // The newest block goes on taking samples if it was flushed before it was full.
+    // Either way its last sample is the one the next append must not precede.
+    auto reopen(const Block& block) -> EEPROM_Status {
+        mLastTimestamp = block.header.timestamp;
+        mLastValue = block.header.value;
+        uint8_t position = 0;
+        for(uint16_t i = 1; i < block.header.count; ++i) {
+            if(!getSample(block, position, mLastTimestamp, mLastValue)) {
+                return EEPROM_Status_InvalidCRC;
+            }
+        }
+        mHasSamples = true;
+        mOpen = Block{};
+        if(block.header.isSealed) {
+            mNext = block.header.sequence + 1;
+            return EEPROM_Status_Sucess;
+        }
+        mNext = block.header.sequence;
+        mOpen = block;
+        return EEPROM_Status_Sucess;
+    }
+
+    void openBlock(uint32_t sequence, uint32_t timestamp, int32_t value) {
+        mOpen = Block{};
+        mOpen.header = Header{sequence, timestamp, value, 1, 0, 0};
+        mLastTimestamp = timestamp;
+        mLastValue = value;
+        mHasSamples = true;
+        ++mReport.samples;
+    }
+
+    // False once the buffer is full
+    auto decode(const Block& block, uint32_t from, uint32_t to, EEPROM_SeriesSample* samples, uint16_t capacity, uint16_t& count) const -> bool {
+        auto timestamp = block.header.timestamp;
+        auto value = block.header.value;
+        uint8_t position = 0;
+        for(uint16_t i = 0; i < block.header.count; ++i) {
+            if(i != 0 && !getSample(block, position, timestamp, value)) {
+                return true;
+            }
+            if(timestamp > to) {
+                return true;
+            }
+            if(timestamp >= from) {
+                if(count == capacity) {
+                    return false;
+                }
+                samples[count++] = EEPROM_SeriesSample{timestamp, value};
+            }
+        }
+        return true;
+    }
+
+    auto getSample(const Block& block, uint8_t& position, uint32_t& timestamp, int32_t& value) const -> bool {
+        uint32_t timestampDelta{};
+        uint32_t valueDelta{};
+        if(!getVarint(block, position, timestampDelta) || !getVarint(block, position, valueDelta)) {
+            return false;
+        }
+        timestamp += timestampDelta;
+        value = static_cast<int32_t>(static_cast<uint32_t>(value) + unzigzag(valueDelta));
+        return true;
+    }
+
+    static auto putVarint(uint8_t* bytes, uint32_t number) -> uint8_t {
+        uint8_t size = 0;
+        while(number >= 0x80) {
+            bytes[size++] = static_cast<uint8_t>(number | 0x80);
+            number >>= 7;
+        }
+        bytes[size++] = static_cast<uint8_t>(number);
+        return size;
+    }
+
+    static auto getVarint(const Block& block, uint8_t& position, uint32_t& number) -> bool {
+        number = 0;
+        for(uint8_t shift = 0; shift < 35; shift += 7) {
+            if(position >= block.header.size) {
+                return false;
+            }
+            auto byte = block.data[position++];
+            number |= static_cast<uint32_t>(byte & 0x7F) << shift;
+            if((byte & 0x80) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Small negative deltas stay small: 0, -1, 1, -2... become 0, 1, 2, 3...
+    static auto zigzag(uint32_t delta) -> uint32_t {
+        return (delta << 1) ^ (0u - (delta >> 31));
+    }
+
+    static auto unzigzag(uint32_t number) -> uint32_t {
+        return (number >> 1) ^ (0u - (number & 1));
+    }
+
+    void prepareWrite() {
+        mWriteBlock = mOpen;
+        auto crc = calcCRC(mWriteBlock);
+        memcpy(reinterpret_cast<uint8_t*>(&mWriteBlock) + mPageSize - 4, &crc, 4);
+    }
+
+    auto submitWrite() -> EEPROM_Status {
+        auto status = EEPROM_WriteDeviceRawAsync(mConfig.device, &mOperation, getPage(mWriteBlock.header.sequence),
+                                                 reinterpret_cast<uint8_t*>(&mWriteBlock), mPageSize);
+        if(status == EEPROM_Status_Sucess) {
+            ++mReport.blockWrites;
+        }
+        return status;
+    }
+
+    auto waitForWrite() -> EEPROM_Status {
+        while(mOperation.status == EEPROM_Status_Pending) {
+            EEPROM_Step();
+        }
+        return mOperation.status;
+    }
+
+    // A lost block would end the series at the next boot, so a failed write is retried first
+    auto finishWrite() -> EEPROM_Status {
+        if(waitForWrite() == EEPROM_Status_Sucess) {
+            return EEPROM_Status_Sucess;
+        }
+        if(auto status = submitWrite(); status != EEPROM_Status_Sucess) {
+            return status;
+        }
+        return waitForWrite();
+    }
+
+    auto readSequence(uint32_t sequence, Block& block) -> EEPROM_Status {
+        ++mReport.blockReads;
+        auto status = readBlock(sequence % mConfig.pageCount, block);
+        if(status == EEPROM_Status_Sucess && block.header.sequence != sequence) {
+            return EEPROM_Status_InvalidCRC;
+        }
+        return status;
+    }
+
+    auto readBlock(uint32_t slot, Block& block) -> EEPROM_Status {
+        EEPROM_Operation operation{};
+        auto status = EEPROM_ReadDeviceRawAsync(mConfig.device, &operation, static_cast<uint16_t>(mConfig.firstPage + slot),
+                                                reinterpret_cast<uint8_t*>(&block), mPageSize);
+        if(status != EEPROM_Status_Sucess) {
+            return status;
+        }
+        while(operation.status == EEPROM_Status_Pending) {
+            EEPROM_Step();
+        }
+        if(operation.status != EEPROM_Status_Sucess) {
+            return operation.status;
+        }
+        uint32_t crc{};
+        memcpy(&crc, reinterpret_cast<uint8_t*>(&block) + mPageSize - 4, 4);
+        if(crc != calcCRC(block) || block.header.sequence % mConfig.pageCount != slot) {
+            return EEPROM_Status_InvalidCRC;
+        }
+        if(block.header.count == 0 || block.header.size > mDataCapacity) {
+            return EEPROM_Status_InvalidCRC;
+        }
+        return EEPROM_Status_Sucess;
+    }
+
+    // The open block takes a page, so one block less than the pages is kept
+    auto getFirstSequence() const -> uint32_t {
+        return mNext >= mConfig.pageCount ? mNext - (mConfig.pageCount - 1) : 0;
+    }
+
+    auto getPage(uint32_t sequence) const -> uint16_t {
+        return static_cast<uint16_t>(mConfig.firstPage + sequence % mConfig.pageCount);
+    }
+
+    auto calcCRC(Block& block) const -> uint32_t {
+        return HAL_CRC_Calculate(mConfig.hCRC, reinterpret_cast<uint32_t*>(&block), (mPageSize - 4) / 4);
+    }
+
+    EEPROM_SeriesConfig mConfig{};
+    uint16_t mPageSize{};
+    uint8_t mDataCapacity{};
+    uint32_t mNext{};
+    Block mOpen{};
+    Block mWriteBlock{};
+    uint32_t mLastTimestamp{};
+    int32_t mLastValue{};
+    bool mHasSamples{};
+    EEPROM_Operation mOperation{};
+    EEPROM_SeriesReport mReport{};
+};
+
+static auto sSeries = Series{};
+
+EEPROM_Status EEPROM_Series_Init(EEPROM_SeriesConfig config) {
+    return sSeries.init(config);
+}
+
+EEPROM_Status EEPROM_Series_Append(uint32_t timestamp, int32_t value) {
+    return sSeries.append(timestamp, value);
+}
+
+EEPROM_Status EEPROM_Series_Flush(void) {
+    return sSeries.flush();
+}
+
+EEPROM_Status EEPROM_Series_Query(uint32_t from, uint32_t to, EEPROM_SeriesSample* samples, uint16_t capacity, uint16_t* count) {
+    return sSeries.query(from, to, samples, capacity, *count);
+}
+
+EEPROM_SeriesReport EEPROM_Series_getReport(void) {
+    return sSeries.getReport();
+}
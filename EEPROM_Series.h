@@ -0,0 +1,48 @@
+#pragma once
+#include "EEPROM.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// RAM for one block, the page size of the device must fit and be a multiple of 4
+#ifndef EEPROM_SERIES_BLOCK_SIZE
+#define EEPROM_SERIES_BLOCK_SIZE 64
+#endif
+
+typedef struct {
+  uint32_t timestamp;
+  int32_t value;
+} EEPROM_SeriesSample;
+
+// One block per page over pageCount pages from firstPage on, at least 2. A block holds the
+// timestamp and value of its first sample, the rest are varint deltas of the previous one.
+typedef struct {
+  CRC_HandleTypeDef* hCRC;
+  uint8_t device;
+  uint16_t firstPage;
+  uint16_t pageCount;
+} EEPROM_SeriesConfig;
+
+typedef struct {
+  uint32_t samples;
+  uint32_t blockWrites;
+  // Blocks read from the EEPROM by queries, the search for the first one included
+  uint32_t blockReads;
+} EEPROM_SeriesReport;
+
+// Finds the newest block and reopens it if it was flushed before it was full
+EEPROM_Status EEPROM_Series_Init(EEPROM_SeriesConfig config);
+// Timestamps must not decrease. Samples stay in RAM until their block is full, then the block
+// is written in the background by EEPROM_Step(). The oldest block is overwritten when the pages are used up.
+EEPROM_Status EEPROM_Series_Append(uint32_t timestamp, int32_t value);
+// Writes the open block, blocking. A torn flush loses the samples of that block.
+EEPROM_Status EEPROM_Series_Flush(void);
+// Samples with from <= timestamp <= to, oldest first, unflushed ones included. Only the blocks
+// covering the window are decoded. A full buffer ends the query, it goes on from the last timestamp.
+EEPROM_Status EEPROM_Series_Query(uint32_t from, uint32_t to, EEPROM_SeriesSample* samples, uint16_t capacity, uint16_t* count);
+EEPROM_SeriesReport EEPROM_Series_getReport(void);
+
+#ifdef __cplusplus
+}
+#endif
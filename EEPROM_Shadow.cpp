@@ -0,0 +1,173 @@
+#include "EEPROM_Shadow.h"
+#include <atomic>
+
+static_assert(EEPROM_SHADOW_MAX_SIZE % 4 == 0, "EEPROM_SHADOW_MAX_SIZE must be a multiple of 4");
+
+// Double buffer with a sequence per buffer: an update fills the buffer readers
+// don't use and flips the published index. A reader only has to retry when an
+// update of higher priority ran twice during its copy, an ISR preempting the
+// updater never waits.
+class Shadow {
+    struct Record {
+        std::atomic<uint32_t> sequences[2];
+        std::atomic<uint8_t> published;
+        uint8_t buffers[2][EEPROM_SHADOW_MAX_SIZE];
+        uint8_t writeBuffer[EEPROM_SHADOW_MAX_SIZE];
+        EEPROM_Operation operation;
+        uint16_t page;
+        uint16_t size;
+        uint8_t device;
+        std::atomic<bool> isRegistered;
+        bool isDirty;
+    };
+
+public:
+    auto registerRecord(uint8_t slot, uint8_t device, uint16_t page, uint16_t size, const uint8_t* defaults) -> EEPROM_Status {
+        if(slot >= EEPROM_SHADOW_MAX_RECORDS || size > EEPROM_SHADOW_MAX_SIZE || size % 4 != 0) {
+            return EEPROM_Status_Error;
+        }
+        auto& record = mRecords[slot];
+        if(record.operation.status == EEPROM_Status_Pending) {
+            return EEPROM_Status_Busy;
+        }
+        record.isRegistered.store(false, std::memory_order_release);
+        auto status = EEPROM_ReadDevice(device, page, record.writeBuffer, size);
+        auto useDefaults = status == EEPROM_Status_InvalidCRC && defaults != nullptr;
+        if(status != EEPROM_Status_Sucess && !useDefaults) {
+            return status;
+        }
+        record.device = device;
+        record.page = page;
+        record.size = size;
+        // Defaults are stored by the next EEPROM_Step()
+        record.isDirty = useDefaults;
+        publish(record, useDefaults ? defaults : record.writeBuffer);
+        record.isRegistered.store(true, std::memory_order_release);
+        if(!mTaskAdded) {
+            mTask.run = [](void* context) { static_cast<Shadow*>(context)->step(); };
+            mTask.context = this;
+            EEPROM_addBackgroundTask(&mTask);
+            mTaskAdded = true;
+        }
+        return EEPROM_Status_Sucess;
+    }
+
+    auto read(uint8_t slot, uint8_t* bytes) const -> EEPROM_Status {
+        if(slot >= EEPROM_SHADOW_MAX_RECORDS || !mRecords[slot].isRegistered.load(std::memory_order_acquire)) {
+            return EEPROM_Status_NotInitialized;
+        }
+        copy(mRecords[slot], bytes);
+        return EEPROM_Status_Sucess;
+    }
+
+    auto update(uint8_t slot, const uint8_t* bytes) -> EEPROM_Status {
+        if(slot >= EEPROM_SHADOW_MAX_RECORDS || !mRecords[slot].isRegistered.load(std::memory_order_acquire)) {
+            return EEPROM_Status_NotInitialized;
+        }
+        auto& record = mRecords[slot];
+        publish(record, bytes);
+        record.isDirty = true;
+        return EEPROM_Status_Sucess;
+    }
+
+    auto flush() -> EEPROM_Status {
+        for(;;) {
+            auto isDone = true;
+            for(auto& record : mRecords) {
+                isDone = isDone && !record.isDirty && record.operation.status != EEPROM_Status_Pending;
+            }
+            if(isDone) {
+                break;
+            }
+            EEPROM_Step();
+        }
+        for(auto& record : mRecords) {
+            if(record.isRegistered.load(std::memory_order_relaxed) && record.operation.status != EEPROM_Status_Sucess) {
+                return record.operation.status;
+            }
+        }
+        return EEPROM_Status_Sucess;
+    }
+
+    auto getWriteStatus(uint8_t slot) const -> EEPROM_Status {
+        if(slot >= EEPROM_SHADOW_MAX_RECORDS) {
+            return EEPROM_Status_NotInitialized;
+        }
+        return mRecords[slot].operation.status;
+    }
+
+private:
+
+    // Updates made during a write are written by the next one, from a snapshot the readers can't change
+    void step() {
+        for(auto& record : mRecords) {
+            if(record.operation.status == EEPROM_Status_Pending) {
+                continue;
+            }
+            if(!record.isDirty) {
+                continue;
+            }
+            record.isDirty = false;
+            copy(record, record.writeBuffer);
+            auto status = EEPROM_WriteDeviceAsync(record.device, &record.operation, record.page, record.writeBuffer, record.size);
+            if(status != EEPROM_Status_Sucess) {
+                record.operation.status = status;
+            }
+        }
+    }
+
+    static void publish(Record& record, const uint8_t* bytes) {
+        auto next = static_cast<uint8_t>(record.published.load(std::memory_order_relaxed) ^ 1);
+        auto sequence = record.sequences[next].load(std::memory_order_relaxed);
+        record.sequences[next].store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for(uint16_t i = 0; i < record.size; ++i) {
+            record.buffers[next][i] = bytes[i];
+        }
+        record.sequences[next].store(sequence + 2, std::memory_order_release);
+        record.published.store(next, std::memory_order_release);
+    }
+
+    static void copy(const Record& record, uint8_t* bytes) {
+        for(;;) {
+            auto index = record.published.load(std::memory_order_acquire);
+            auto sequence = record.sequences[index].load(std::memory_order_acquire);
+            if(sequence & 1) {
+                continue;
+            }
+            for(uint16_t i = 0; i < record.size; ++i) {
+                bytes[i] = record.buffers[index][i];
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if(record.sequences[index].load(std::memory_order_relaxed) == sequence) {
+                return;
+            }
+        }
+    }
+
+    Record mRecords[EEPROM_SHADOW_MAX_RECORDS]{};
+    EEPROM_BackgroundTask mTask{};
+    bool mTaskAdded{};
+};
+
+static auto sShadow = Shadow{};
+
+EEPROM_Status EEPROM_Shadow_Register(uint8_t slot, uint8_t device, uint16_t page, uint16_t size, const uint8_t* defaults) {
+    return sShadow.registerRecord(slot, device, page, size, defaults);
+}
+
+EEPROM_Status EEPROM_Shadow_Read(uint8_t slot, uint8_t* bytes) {
+    return sShadow.read(slot, bytes);
+}
+
+EEPROM_Status EEPROM_Shadow_Update(uint8_t slot, const uint8_t* bytes) {
+    return sShadow.update(slot, bytes);
+}
+
+EEPROM_Status EEPROM_Shadow_Flush(void) {
+    return sShadow.flush();
+}
+
+EEPROM_Status EEPROM_Shadow_getWriteStatus(uint8_t slot) {
+    return sShadow.getWriteStatus(slot);
+}
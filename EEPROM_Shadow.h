@@ -0,0 +1,33 @@
+#pragma once
+#include "EEPROM.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef EEPROM_SHADOW_MAX_RECORDS
+#define EEPROM_SHADOW_MAX_RECORDS 4
+#endif
+
+// Largest cached record, a multiple of 4
+#ifndef EEPROM_SHADOW_MAX_SIZE
+#define EEPROM_SHADOW_MAX_SIZE 64
+#endif
+
+// Loads the record from the EEPROM into the cache, blocking. A record with a
+// bad CRC takes the defaults, if given, and they are written back.
+EEPROM_Status EEPROM_Shadow_Register(uint8_t slot, uint8_t device, uint16_t page, uint16_t size, const uint8_t* defaults);
+// Safe from interrupts of any priority: copies a consistent snapshot without
+// locks or driver calls. Retries only if an update preempted the copy itself.
+EEPROM_Status EEPROM_Shadow_Read(uint8_t slot, uint8_t* bytes);
+// Publishes the new contents to the readers at once, EEPROM_Step() writes them
+// through to the EEPROM. Thread context only, one updater at a time.
+EEPROM_Status EEPROM_Shadow_Update(uint8_t slot, const uint8_t* bytes);
+// Waits until every update reached the EEPROM, the first failure is returned
+EEPROM_Status EEPROM_Shadow_Flush(void);
+// Status of the last write-through of the slot
+EEPROM_Status EEPROM_Shadow_getWriteStatus(uint8_t slot);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,311 @@
+#include "EEPROM_Snapshot.h"
+
+class Snapshot {
+    static constexpr uint16_t sNoPage = 0xFFFF;
+
+    // Stored with the CRC of the driver, the page CRCs guard the shared data pages
+    struct VersionEntry {
+        uint32_t version;
+        uint32_t crcs[EEPROM_SNAPSHOT_MAX_PAGES];
+        uint16_t pages[EEPROM_SNAPSHOT_MAX_PAGES];
+    };
+
+    static_assert(sizeof(VersionEntry) % 4 == 0, "EEPROM_SNAPSHOT_MAX_PAGES must be even");
+
+public:
+    auto init(const EEPROM_SnapshotConfig& config) -> EEPROM_Status {
+        auto pageSize = EEPROM_getDevicePageSize(config.device);
+        if(config.hCRC == nullptr || pageSize == 0) {
+            return EEPROM_Status_NotInitialized;
+        }
+        if(config.versions < 2 || config.versions > EEPROM_SNAPSHOT_MAX_VERSIONS || config.size % 4 != 0 ||
+           pageSize > EEPROM_SNAPSHOT_SCRATCH_SIZE || (config.size + pageSize - 1) / pageSize > EEPROM_SNAPSHOT_MAX_PAGES) {
+            return EEPROM_Status_Error;
+        }
+        mConfig = config;
+        mPageSize = pageSize;
+        for(uint8_t slot = 0; slot < mConfig.versions; ++slot) {
+            auto& entry = mEntries[slot];
+            auto status = EEPROM_ReadDevice(mConfig.device, getSlotPage(slot), reinterpret_cast<uint8_t*>(&entry), sizeof(entry));
+            if(status == EEPROM_Status_Timeout || status == EEPROM_Status_Error) {
+                mPageSize = 0;
+                return status;
+            }
+            // A version lives in the slot it maps to, anything else is a stale or broken entry
+            if(status != EEPROM_Status_Sucess || entry.version == 0 || entry.version % mConfig.versions != slot) {
+                entry.version = 0;
+            }
+        }
+        return EEPROM_Status_Sucess;
+    }
+
+    auto isInitialized() const {
+        return mPageSize != 0;
+    }
+
+    auto getPagesCount(const EEPROM_SnapshotConfig& config) const -> uint16_t {
+        auto pageSize = EEPROM_getDevicePageSize(config.device);
+        if(pageSize == 0) {
+            return 0;
+        }
+        return config.versions * getSlotPagesCount(pageSize) + config.dataPageCount;
+    }
+
+    // Pages with an unchanged CRC are compared with the stored ones, the others are written to free pages
+    auto save(uint8_t* buffer, uint32_t& version) -> EEPROM_Status {
+        if(!isInitialized()) {
+            return EEPROM_Status_NotInitialized;
+        }
+        auto current = findEntry(getCurrentVersion());
+        VersionEntry entry{};
+        entry.version = getCurrentVersion() + 1;
+        auto replacedSlot = static_cast<uint8_t>(entry.version % mConfig.versions);
+        EEPROM_Operation operations[EEPROM_SNAPSHOT_MAX_PAGES]{};
+        uint8_t writes = 0;
+        for(uint16_t i = 0; i < getRecordPagesCount(); ++i) {
+            auto bytes = buffer + i * mPageSize;
+            auto size = getBlockSize(i);
+            entry.crcs[i] = calcCRC(bytes, size);
+            if(current != nullptr && current->crcs[i] == entry.crcs[i]) {
+                auto isEqual = false;
+                if(auto status = isPageEqual(current->pages[i], bytes, size, isEqual); status != EEPROM_Status_Sucess) {
+                    return status;
+                }
+                if(isEqual) {
+                    entry.pages[i] = current->pages[i];
+                    continue;
+                }
+            }
+            entry.pages[i] = findFreePage(entry, i, replacedSlot);
+            if(entry.pages[i] == sNoPage) {
+                wait(operations, writes);
+                return EEPROM_Status_Error;
+            }
+            auto status = EEPROM_WriteDeviceRawAsync(mConfig.device, &operations[writes++], getDataPage(entry.pages[i]), bytes, size);
+            if(status != EEPROM_Status_Sucess) {
+                wait(operations, writes);
+                return status;
+            }
+        }
+        if(auto status = wait(operations, writes); status != EEPROM_Status_Sucess) {
+            return status;
+        }
+        if(auto status = writeEntry(entry); status != EEPROM_Status_Sucess) {
+            return status;
+        }
+        version = entry.version;
+        return EEPROM_Status_Sucess;
+    }
+
+    auto read(uint32_t version, uint8_t* buffer) -> EEPROM_Status {
+        if(!isInitialized()) {
+            return EEPROM_Status_NotInitialized;
+        }
+        auto entry = findEntry(version);
+        if(entry == nullptr) {
+            return EEPROM_Status_Error;
+        }
+        EEPROM_Operation operations[EEPROM_SNAPSHOT_MAX_PAGES]{};
+        for(uint16_t i = 0; i < getRecordPagesCount(); ++i) {
+            auto status = EEPROM_ReadDeviceRawAsync(mConfig.device, &operations[i], getDataPage(entry->pages[i]),
+                                                    buffer + i * mPageSize, getBlockSize(i));
+            if(status != EEPROM_Status_Sucess) {
+                wait(operations, i);
+                return status;
+            }
+        }
+        if(auto status = wait(operations, getRecordPagesCount()); status != EEPROM_Status_Sucess) {
+            return status;
+        }
+        for(uint16_t i = 0; i < getRecordPagesCount(); ++i) {
+            if(calcCRC(buffer + i * mPageSize, getBlockSize(i)) != entry->crcs[i]) {
+                return EEPROM_Status_InvalidCRC;
+            }
+        }
+        return EEPROM_Status_Sucess;
+    }
+
+    // The entry is copied before the write, the new version may replace the slot of the old one
+    auto rollback(uint32_t version) -> EEPROM_Status {
+        if(!isInitialized()) {
+            return EEPROM_Status_NotInitialized;
+        }
+        auto source = findEntry(version);
+        if(source == nullptr) {
+            return EEPROM_Status_Error;
+        }
+        auto entry = *source;
+        entry.version = getCurrentVersion() + 1;
+        return writeEntry(entry);
+    }
+
+    auto getCurrentVersion() const -> uint32_t {
+        uint32_t version = 0;
+        for(uint8_t slot = 0; slot < mConfig.versions; ++slot) {
+            if(mEntries[slot].version > version) {
+                version = mEntries[slot].version;
+            }
+        }
+        return version;
+    }
+
+    auto getOldestVersion() const -> uint32_t {
+        uint32_t version = 0;
+        for(uint8_t slot = 0; slot < mConfig.versions; ++slot) {
+            if(mEntries[slot].version != 0 && (version == 0 || mEntries[slot].version < version)) {
+                version = mEntries[slot].version;
+            }
+        }
+        return version;
+    }
+
+private:
+
+    auto writeEntry(VersionEntry& entry) -> EEPROM_Status {
+        auto slot = static_cast<uint8_t>(entry.version % mConfig.versions);
+        auto status = EEPROM_WriteDevice(mConfig.device, getSlotPage(slot), reinterpret_cast<uint8_t*>(&entry), sizeof(entry));
+        // A failed write may have torn the slot, its old version is gone either way
+        mEntries[slot] = entry;
+        if(status != EEPROM_Status_Sucess) {
+            mEntries[slot].version = 0;
+        }
+        return status;
+    }
+
+    auto findEntry(uint32_t version) const -> const VersionEntry* {
+        if(version == 0) {
+            return nullptr;
+        }
+        auto& entry = mEntries[version % mConfig.versions];
+        return entry.version == version ? &entry : nullptr;
+    }
+
+    // Pages of the version in the replaced slot are free, it is dropped by this save
+    auto findFreePage(const VersionEntry& entry, uint16_t count, uint8_t replacedSlot) const -> uint16_t {
+        for(uint16_t page = 0; page < mConfig.dataPageCount; ++page) {
+            auto isUsed = false;
+            for(uint8_t slot = 0; slot < mConfig.versions && !isUsed; ++slot) {
+                if(slot != replacedSlot && mEntries[slot].version != 0) {
+                    isUsed = isReferenced(mEntries[slot], getRecordPagesCount(), page);
+                }
+            }
+            if(!isUsed && !isReferenced(entry, count, page)) {
+                return page;
+            }
+        }
+        return sNoPage;
+    }
+
+    static auto isReferenced(const VersionEntry& entry, uint16_t count, uint16_t page) -> bool {
+        for(uint16_t i = 0; i < count; ++i) {
+            if(entry.pages[i] == page) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    auto isPageEqual(uint16_t page, const uint8_t* bytes, uint16_t size, bool& isEqual) -> EEPROM_Status {
+        EEPROM_Operation operation{};
+        auto status = EEPROM_ReadDeviceRawAsync(mConfig.device, &operation, getDataPage(page), mScratch, size);
+        if(status != EEPROM_Status_Sucess) {
+            return status;
+        }
+        status = wait(&operation, 1);
+        if(status != EEPROM_Status_Sucess) {
+            return status;
+        }
+        isEqual = true;
+        for(uint16_t i = 0; i < size && isEqual; ++i) {
+            isEqual = mScratch[i] == bytes[i];
+        }
+        return EEPROM_Status_Sucess;
+    }
+
+    static auto wait(const EEPROM_Operation* operations, uint8_t count) -> EEPROM_Status {
+        while(EEPROM_getGroupStatus(operations, count) == EEPROM_Status_Pending) {
+            EEPROM_Step();
+        }
+        return EEPROM_getGroupStatus(operations, count);
+    }
+
+    auto getRecordPagesCount() const -> uint16_t {
+        return (mConfig.size + mPageSize - 1) / mPageSize;
+    }
+
+    auto getBlockSize(uint16_t index) const -> uint16_t {
+        auto remain = mConfig.size - index * mPageSize;
+        return remain > mPageSize ? mPageSize : remain;
+    }
+
+    auto getSlotPage(uint8_t slot) const -> uint16_t {
+        return mConfig.firstPage + slot * getSlotPagesCount(mPageSize);
+    }
+
+    auto getDataPage(uint16_t page) const -> uint16_t {
+        return mConfig.firstPage + mConfig.versions * getSlotPagesCount(mPageSize) + page;
+    }
+
+    // Data pages and the CRC page, the layout of EEPROM_getBuffersPagesCount()
+    static auto getSlotPagesCount(uint16_t pageSize) -> uint16_t {
+        return sizeof(VersionEntry) / pageSize + 2;
+    }
+
+    auto calcCRC(uint8_t* bytes, uint16_t size) const -> uint32_t {
+        return HAL_CRC_Calculate(mConfig.hCRC, reinterpret_cast<uint32_t*>(bytes), size / 4);
+    }
+
+    EEPROM_SnapshotConfig mConfig{};
+    uint16_t mPageSize{};
+    VersionEntry mEntries[EEPROM_SNAPSHOT_MAX_VERSIONS]{};
+    uint8_t mScratch[EEPROM_SNAPSHOT_SCRATCH_SIZE]{};
+};
+
+static Snapshot sSnapshots[EEPROM_SNAPSHOT_MAX_RECORDS];
+
+EEPROM_Status EEPROM_Snapshot_Init(uint8_t record, EEPROM_SnapshotConfig config) {
+    if(record >= EEPROM_SNAPSHOT_MAX_RECORDS) {
+        return EEPROM_Status_NotInitialized;
+    }
+    return sSnapshots[record].init(config);
+}
+
+uint16_t EEPROM_Snapshot_getPagesCount(EEPROM_SnapshotConfig config) {
+    return sSnapshots[0].getPagesCount(config);
+}
+
+EEPROM_Status EEPROM_Snapshot_Save(uint8_t record, uint8_t* bytes, uint32_t* version) {
+    if(record >= EEPROM_SNAPSHOT_MAX_RECORDS) {
+        return EEPROM_Status_NotInitialized;
+    }
+    return sSnapshots[record].save(bytes, *version);
+}
+
+EEPROM_Status EEPROM_Snapshot_Read(uint8_t record, uint8_t* bytes) {
+    if(record >= EEPROM_SNAPSHOT_MAX_RECORDS) {
+        return EEPROM_Status_NotInitialized;
+    }
+    return sSnapshots[record].read(sSnapshots[record].getCurrentVersion(), bytes);
+}
+
+EEPROM_Status EEPROM_Snapshot_ReadVersion(uint8_t record, uint32_t version, uint8_t* bytes) {
+    if(record >= EEPROM_SNAPSHOT_MAX_RECORDS) {
+        return EEPROM_Status_NotInitialized;
+    }
+    return sSnapshots[record].read(version, bytes);
+}
+
+EEPROM_Status EEPROM_Snapshot_Rollback(uint8_t record, uint32_t version) {
+    if(record >= EEPROM_SNAPSHOT_MAX_RECORDS) {
+        return EEPROM_Status_NotInitialized;
+    }
+    return sSnapshots[record].rollback(version);
+}
+
+uint32_t EEPROM_Snapshot_getCurrentVersion(uint8_t record) {
+    return record < EEPROM_SNAPSHOT_MAX_RECORDS ? sSnapshots[record].getCurrentVersion() : 0;
+}
+
+uint32_t EEPROM_Snapshot_getOldestVersion(uint8_t record) {
+    return record < EEPROM_SNAPSHOT_MAX_RECORDS ? sSnapshots[record].getOldestVersion() : 0;
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include "EEPROM.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef EEPROM_SNAPSHOT_MAX_RECORDS
+#define EEPROM_SNAPSHOT_MAX_RECORDS 2
+#endif
+
+#ifndef EEPROM_SNAPSHOT_MAX_VERSIONS
+#define EEPROM_SNAPSHOT_MAX_VERSIONS 4
+#endif
+
+// Pages of one record, must be even
+#ifndef EEPROM_SNAPSHOT_MAX_PAGES
+#define EEPROM_SNAPSHOT_MAX_PAGES 8
+#endif
+
+// Must hold one page of the device
+#ifndef EEPROM_SNAPSHOT_SCRATCH_SIZE
+#define EEPROM_SNAPSHOT_SCRATCH_SIZE 128
+#endif
+
+// A record keeps its last `versions` versions, at least 2. The index of the versions takes
+// the first pages from firstPage on, the data pages follow it, see
+// EEPROM_Snapshot_getPagesCount(). Unchanged pages are shared between versions,
+// so dataPageCount may be far less than versions times the pages of the record.
+typedef struct {
+  CRC_HandleTypeDef* hCRC;
+  uint8_t device;
+  uint8_t versions;
+  uint16_t firstPage;
+  uint16_t dataPageCount;
+  uint16_t size;
+} EEPROM_SnapshotConfig;
+
+EEPROM_Status EEPROM_Snapshot_Init(uint8_t record, EEPROM_SnapshotConfig config);
+uint16_t EEPROM_Snapshot_getPagesCount(EEPROM_SnapshotConfig config);
+// Writes the changed pages and a new index entry, version receives the new version number
+EEPROM_Status EEPROM_Snapshot_Save(uint8_t record, uint8_t* bytes, uint32_t* version);
+EEPROM_Status EEPROM_Snapshot_Read(uint8_t record, uint8_t* bytes);
+EEPROM_Status EEPROM_Snapshot_ReadVersion(uint8_t record, uint32_t version, uint8_t* bytes);
+// Makes a kept version current again by adding a version that points to its pages,
+// one index write and no data pages
+EEPROM_Status EEPROM_Snapshot_Rollback(uint8_t record, uint32_t version);
+// 0 - nothing was saved yet
+uint32_t EEPROM_Snapshot_getCurrentVersion(uint8_t record);
+uint32_t EEPROM_Snapshot_getOldestVersion(uint8_t record);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,48 @@
+#include "EEPROM_Trace.h"
+
+static_assert((EEPROM_TRACE_SIZE & (EEPROM_TRACE_SIZE - 1)) == 0, "EEPROM_TRACE_SIZE must be a power of two");
+
+#if EEPROM_TRACE_ENABLED
+EEPROM_TraceRecord EEPROM_traceRecords[EEPROM_TRACE_SIZE];
+uint32_t EEPROM_traceHead;
+#endif
+
+void EEPROM_Trace_Init(void) {
+    // No compound assignment, C++20 deprecates it on volatile registers
+    CoreDebug->DEMCR = CoreDebug->DEMCR | CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL = DWT->CTRL | DWT_CTRL_CYCCNTENA_Msk;
+    EEPROM_Trace_Clear();
+}
+
+void EEPROM_Trace_Clear(void) {
+#if EEPROM_TRACE_ENABLED
+    EEPROM_traceHead = 0;
+#endif
+}
+
+void EEPROM_Trace_Dump(EEPROM_TraceWriter writer) {
+#if EEPROM_TRACE_ENABLED
+    auto head = EEPROM_traceHead;
+    uint16_t count = head < EEPROM_TRACE_SIZE ? head : EEPROM_TRACE_SIZE;
+#else
+    uint16_t count = 0;
+#endif
+    auto header = EEPROM_TraceHeader{EEPROM_TRACE_MAGIC, EEPROM_TRACE_VERSION, 
+                                     sizeof(EEPROM_TraceRecord), count, SystemCoreClock};
+    writer(reinterpret_cast<const uint8_t*>(&header), sizeof(header));
+#if EEPROM_TRACE_ENABLED
+    for(auto index = head - count; index != head; ++index) {
+        auto& record = EEPROM_traceRecords[index & (EEPROM_TRACE_SIZE - 1)];
+        writer(reinterpret_cast<const uint8_t*>(&record), sizeof(record));
+    }
+#endif
+}
+
+void EEPROM_Trace_DumpITM(void) {
+    EEPROM_Trace_Dump([](const uint8_t* bytes, uint16_t size) {
+        for(uint16_t i = 0; i < size; ++i) {
+            ITM_SendChar(bytes[i]);
+        }
+    });
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include "main.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Build with EEPROM_TRACE_ENABLED=1 to record driver events,
+// otherwise the trace points compile to nothing
+#ifndef EEPROM_TRACE_ENABLED
+#define EEPROM_TRACE_ENABLED 0
+#endif
+
+// Count of records in the ring, a power of two
+#ifndef EEPROM_TRACE_SIZE
+#define EEPROM_TRACE_SIZE 256
+#endif
+
+#define EEPROM_TRACE_MAGIC 0x52544545u
+#define EEPROM_TRACE_VERSION 1
+
+// Events are recorded when a phase ends, so the time since the previous
+// event of the same chip is the duration of the phase
+typedef enum {
+  EEPROM_TraceEvent_WriteStart,
+  EEPROM_TraceEvent_ReadStart,
+  EEPROM_TraceEvent_OperationEnd,
+  EEPROM_TraceEvent_PageTransfer,
+  EEPROM_TraceEvent_CRCTransfer,
+  EEPROM_TraceEvent_WriteCycle,
+  // info is 1 if the slave released SDA, the address is 0
+  EEPROM_TraceEvent_BusRecovery
+} EEPROM_TraceEvent;
+
+// info: chip select bits of the device address in bits 7..5, the HAL status
+// (transfers) or EEPROM_Status (operation end) in bits 4..0
+typedef struct {
+  uint32_t cycles;
+  uint16_t address;
+  uint8_t event;
+  uint8_t info;
+} EEPROM_TraceRecord;
+
+// Dump layout, followed by count records from the oldest one
+typedef struct {
+  uint32_t magic;
+  uint8_t version;
+  uint8_t recordSize;
+  uint16_t count;
+  uint32_t coreClockHz;
+} EEPROM_TraceHeader;
+
+typedef void (*EEPROM_TraceWriter)(const uint8_t* bytes, uint16_t size);
+
+// Starts the DWT cycle counter used for the timestamps
+void EEPROM_Trace_Init(void);
+void EEPROM_Trace_Clear(void);
+void EEPROM_Trace_Dump(EEPROM_TraceWriter writer);
+void EEPROM_Trace_DumpITM(void);
+
+#if EEPROM_TRACE_ENABLED
+extern EEPROM_TraceRecord EEPROM_traceRecords[EEPROM_TRACE_SIZE];
+extern uint32_t EEPROM_traceHead;
+
+static inline void EEPROM_Trace_record(uint8_t event, uint16_t address, uint8_t info) {
+  EEPROM_TraceRecord* record = &EEPROM_traceRecords[EEPROM_traceHead++ & (EEPROM_TRACE_SIZE - 1)];
+  record->cycles = DWT->CYCCNT;
+  record->address = address;
+  record->event = event;
+  record->info = info;
+}
+#endif
+
+#ifdef __cplusplus
+}
+#endif
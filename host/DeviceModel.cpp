@@ -0,0 +1,119 @@
+#include "DeviceModel.h"
+#include <cmath>
+#include <cstring>
+#include <random>
+
+DeviceModel::DeviceModel(uint32_t capacity, uint16_t pageSize, uint32_t writeCycleMicroseconds)
+    : DeviceModel(nullptr, capacity, pageSize, writeCycleMicroseconds) {
+    mOwnedMemory.assign(capacity, 0xFF);
+    mMemory = mOwnedMemory.data();
+}
+
+DeviceModel::DeviceModel(uint8_t* memory, uint32_t capacity, uint16_t pageSize, uint32_t writeCycleMicroseconds)
+    : mMemory(memory), 
+      mCapacity(capacity), 
+      mPageWrites(capacity / pageSize), 
+      mPageSize(pageSize), 
+      mWriteCycleMicroseconds(writeCycleMicroseconds) {
+}
+
+void DeviceModel::setWearModel(const WearModel& model) {
+    mWearModel = model;
+    mRandom = model.seed;
+    auto capacity = getCapacity();
+    if(model.enduranceCycles == 0) {
+        mCellWrites.clear();
+        return;
+    }
+    mCellWrites.assign(capacity, 0);
+    mCellWritten.assign(capacity, 0);
+    mStuckMask.assign(capacity, 0);
+    mStuckValue.assign(capacity, 0);
+    mCellEndurance.resize(capacity);
+    std::mt19937 generator(model.seed);
+    std::lognormal_distribution<double> distribution(std::log(static_cast<double>(model.enduranceCycles)), model.enduranceSpread);
+    for(auto& endurance : mCellEndurance) {
+        endurance = static_cast<uint32_t>(std::min(distribution(generator), 4e9));
+    }
+    mStuckCells = 0;
+}
+
+auto DeviceModel::write(uint16_t address, const uint8_t* data, uint16_t size, uint64_t now) -> bool {
+    if(isBusy(now)) {
+        return false;
+    }
+    auto pageAddress = (address % getCapacity()) / mPageSize * mPageSize;
+    auto offset = address % mPageSize;
+    if(mCellWrites.empty()) {
+        // Only the last page size bytes land, the earlier ones are overwritten by the wrap
+        if(size > mPageSize) {
+            offset = (offset + size - mPageSize) % mPageSize;
+            data += size - mPageSize;
+            size = mPageSize;
+        }
+        auto head = static_cast<uint16_t>(mPageSize - offset < size ? mPageSize - offset : size);
+        memcpy(mMemory + pageAddress + offset, data, head);
+        memcpy(mMemory + pageAddress, data + head, size - head);
+    } else {
+        for(uint16_t i = 0; i < size; ++i) {
+            auto cell = pageAddress + (offset + i) % mPageSize;
+            mMemory[cell] = data[i];
+            wearCell(cell, now);
+        }
+    }
+    ++mPageWrites[pageAddress / mPageSize];
+    ++mWriteCycles;
+    mBusyUntil = now + mWriteCycleMicroseconds;
+    return true;
+}
+
+// Sequential read rolls over the whole array, not the page
+auto DeviceModel::read(uint16_t address, uint8_t* data, uint16_t size, uint64_t now) -> bool {
+    if(isBusy(now)) {
+        return false;
+    }
+    uint32_t cell = address % getCapacity();
+    if(mCellWrites.empty()) {
+        while(size > 0) {
+            auto chunk = static_cast<uint16_t>(getCapacity() - cell < size ? getCapacity() - cell : size);
+            memcpy(data, mMemory + cell, chunk);
+            data += chunk;
+            size -= chunk;
+            cell = 0;
+        }
+        return true;
+    }
+    for(uint16_t i = 0; i < size; ++i) {
+        data[i] = readCell((cell + i) % getCapacity(), now);
+    }
+    return true;
+}
+
+auto DeviceModel::isBusy(uint64_t now) const -> bool {
+    return now < mBusyUntil;
+}
+
+void DeviceModel::wearCell(uint32_t address, uint64_t now) {
+    mCellWrites[address] += mWearModel.wearScale;
+    mCellWritten[address] = now;
+    if(mStuckMask[address] == 0 && mCellWrites[address] > mCellEndurance[address]) {
+        // xorshift, the model has to stay reproducible for a seed
+        mRandom ^= mRandom << 13;
+        mRandom ^= mRandom >> 17;
+        mRandom ^= mRandom << 5;
+        mStuckMask[address] = static_cast<uint8_t>(1u << (mRandom & 7));
+        mStuckValue[address] = static_cast<uint8_t>(mRandom >> 8);
+        ++mStuckCells;
+    }
+}
+
+auto DeviceModel::readCell(uint32_t address, uint64_t now) const -> uint8_t {
+    auto mask = mStuckMask[address];
+    auto value = static_cast<uint8_t>((mMemory[address] & ~mask) | (mStuckValue[address] & mask));
+    auto isWorn = mCellWrites[address] * 5ull > mCellEndurance[address] * 4ull;
+    if(isWorn && mWearModel.retentionMicroseconds != 0 && now - mCellWritten[address] > mWearModel.retentionMicroseconds) {
+        // Charge loss drifts a bit towards the erased state
+        value |= static_cast<uint8_t>(1u << (address & 7));
+    }
+    return value;
+}
@@ -0,0 +1,99 @@
+#pragma once
+#include <stdint.h>
+#include <vector>
+
+// Wear-out behaviour of the cells, disabled while enduranceCycles is 0.
+// Every cell gets its own endurance drawn from a log-normal distribution
+// around enduranceCycles. A cell past its endurance gets a stuck bit, a cell
+// past 80 % of it loses a bit once retentionMicroseconds passed since its
+// last write. wearScale counts every write cycle as several, to age the
+// part faster than the workload runs.
+struct WearModel {
+    uint32_t enduranceCycles = 0;
+    double enduranceSpread = 0.3;
+    uint64_t retentionMicroseconds = 0;
+    uint32_t wearScale = 1;
+    uint32_t seed = 1;
+};
+
+// I2C EEPROM of the 24xx family as seen from the bus: page writes wrap
+// around within the page, the chip ignores its address during the write cycle.
+// A write cycle of 0 makes the chip ready right after every write.
+class DeviceModel {
+public:
+    DeviceModel(uint32_t capacity, uint16_t pageSize, uint32_t writeCycleMicroseconds = 5000);
+    // Works on external memory, e.g. a slice of a MappedImage, without copying it
+    DeviceModel(uint8_t* memory, uint32_t capacity, uint16_t pageSize, uint32_t writeCycleMicroseconds = 5000);
+
+    void setWearModel(const WearModel& model);
+
+    // Faster transfers are NACKed, 0 accepts any clock
+    void setMaxSpeed(uint32_t speedHz) {
+        mMaxSpeedHz = speedHz;
+    }
+
+    auto supportsSpeed(uint32_t speedHz) const -> bool {
+        return mMaxSpeedHz == 0 || speedHz <= mMaxSpeedHz;
+    }
+
+    auto write(uint16_t address, const uint8_t* data, uint16_t size, uint64_t now) -> bool;
+    auto read(uint16_t address, uint8_t* data, uint16_t size, uint64_t now) -> bool;
+    auto isBusy(uint64_t now) const -> bool;
+
+    auto getCapacity() const -> uint32_t {
+        return mCapacity;
+    }
+
+    auto getPageSize() const -> uint16_t {
+        return mPageSize;
+    }
+
+    auto getMemory() -> uint8_t* {
+        return mMemory;
+    }
+
+    auto getWriteCycles() const -> uint64_t {
+        return mWriteCycles;
+    }
+
+    // Write cycles per page, the wear of the part
+    auto getPageWrites() const -> const std::vector<uint32_t>& {
+        return mPageWrites;
+    }
+
+    // Write cycles per cell, empty without a wear model
+    auto getCellWrites() const -> const std::vector<uint32_t>& {
+        return mCellWrites;
+    }
+
+    auto getCellEndurance() const -> const std::vector<uint32_t>& {
+        return mCellEndurance;
+    }
+
+    auto getStuckCells() const -> uint32_t {
+        return mStuckCells;
+    }
+
+private:
+    void wearCell(uint32_t address, uint64_t now);
+    auto readCell(uint32_t address, uint64_t now) const -> uint8_t;
+
+    std::vector<uint8_t> mOwnedMemory;
+    uint8_t* mMemory;
+    uint32_t mCapacity;
+    std::vector<uint32_t> mPageWrites;
+    uint16_t mPageSize;
+    uint32_t mWriteCycleMicroseconds;
+    uint64_t mBusyUntil{};
+    uint64_t mWriteCycles{};
+    uint32_t mMaxSpeedHz{};
+
+    WearModel mWearModel;
+    std::vector<uint32_t> mCellWrites;
+    std::vector<uint32_t> mCellEndurance;
+    std::vector<uint64_t> mCellWritten;
+    std::vector<uint8_t> mStuckMask;
+    std::vector<uint8_t> mStuckValue;
+    uint32_t mStuckCells{};
+    uint32_t mRandom{};
+};
@@ -0,0 +1,95 @@
+#include "FileI2CDevice.h"
+#include "HostClock.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+FileI2CDevice::FileI2CDevice(const char* path, uint16_t address, uint32_t capacity, uint16_t pageSize, 
+                             uint32_t writeCycleMicroseconds)
+    : mFile(open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644)), 
+      mAddress(address), 
+      mCapacity(capacity), 
+      mPageSize(pageSize), 
+      mWriteCycleMicroseconds(writeCycleMicroseconds) {
+    struct stat status{};
+    if(mFile < 0 || fstat(mFile, &status) != 0) {
+        return;
+    }
+    // A new chip comes erased
+    if(static_cast<uint64_t>(status.st_size) < capacity) {
+        std::vector<uint8_t> erased(capacity - status.st_size, 0xFF);
+        if(pwrite(mFile, erased.data(), erased.size(), status.st_size) != static_cast<ssize_t>(erased.size())) {
+            close(mFile);
+            mFile = -1;
+        }
+    }
+}
+
+FileI2CDevice::~FileI2CDevice() {
+    if(mFile >= 0) {
+        close(mFile);
+    }
+}
+
+auto FileI2CDevice::transfer(i2c_msg* messages, uint32_t count) -> int {
+    if(count == 0 || messages[0].addr != mAddress || HostClock::now() < mBusyUntil) {
+        return -EREMOTEIO;
+    }
+    for(uint32_t i = 0; i < count; ++i) {
+        auto& message = messages[i];
+        if(message.addr != mAddress) {
+            return -EREMOTEIO;
+        }
+        if(message.flags & I2C_M_RD) {
+            if(!read(message.buf, message.len)) {
+                return -EIO;
+            }
+            continue;
+        }
+        if(message.len >= 2) {
+            mPointer = ((message.buf[0] << 8) | message.buf[1]) % mCapacity;
+        }
+        if(message.len > 2) {
+            if(!write(message.buf + 2, message.len - 2)) {
+                return -EIO;
+            }
+            // The write cycle starts with the STOP, only the last message may write
+            mBusyUntil = HostClock::now() + mWriteCycleMicroseconds;
+        }
+    }
+    return 0;
+}
+
+auto FileI2CDevice::write(const uint8_t* data, uint16_t size) -> bool {
+    auto pageAddress = mPointer / mPageSize * mPageSize;
+    auto offset = mPointer % mPageSize;
+    // Bytes past the end of the page wrap around to its start
+    while(size > 0) {
+        auto chunk = static_cast<uint16_t>(mPageSize - offset < size ? mPageSize - offset : size);
+        ++mFileCalls;
+        if(pwrite(mFile, data, chunk, pageAddress + offset) != chunk) {
+            return false;
+        }
+        data += chunk;
+        size -= chunk;
+        offset = (offset + chunk) % mPageSize;
+    }
+    mPointer = pageAddress + offset;
+    return true;
+}
+
+auto FileI2CDevice::read(uint8_t* data, uint16_t size) -> bool {
+    while(size > 0) {
+        auto chunk = static_cast<uint16_t>(mCapacity - mPointer < size ? mCapacity - mPointer : size);
+        ++mFileCalls;
+        if(pread(mFile, data, chunk, mPointer) != chunk) {
+            return false;
+        }
+        data += chunk;
+        size -= chunk;
+        mPointer = (mPointer + chunk) % mCapacity;
+    }
+    return true;
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include "LinuxI2CBus.h"
+
+// Stand-in for an EEPROM behind /dev/i2c-N, kept in a file so the contents
+// survive between runs. Answers I2C_RDWR requests like a 24xx chip with 16-bit
+// addressing: page writes wrap around within the page, the chip NACKs during
+// the write cycle, reads are sequential over the whole array.
+class FileI2CDevice : public I2CTransport {
+public:
+    FileI2CDevice(const char* path, uint16_t address, uint32_t capacity, uint16_t pageSize, 
+                  uint32_t writeCycleMicroseconds = 5000);
+    ~FileI2CDevice() override;
+
+    auto isOpen() const -> bool {
+        return mFile >= 0;
+    }
+
+    auto transfer(i2c_msg* messages, uint32_t count) -> int override;
+
+    // File system calls made to serve the requests
+    auto getFileCalls() const -> uint64_t {
+        return mFileCalls;
+    }
+
+private:
+    auto write(const uint8_t* data, uint16_t size) -> bool;
+    auto read(uint8_t* data, uint16_t size) -> bool;
+
+    int mFile;
+    uint16_t mAddress;
+    uint32_t mCapacity;
+    uint16_t mPageSize;
+    uint32_t mWriteCycleMicroseconds;
+    uint32_t mPointer{};
+    uint64_t mBusyUntil{};
+    uint64_t mFileCalls{};
+};
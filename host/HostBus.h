@@ -0,0 +1,23 @@
+#pragma once
+#include "main.h"
+
+// Transport behind I2C_HandleTypeDef::Instance in the host build
+class HostBus {
+public:
+    virtual ~HostBus() = default;
+    virtual auto memWrite(uint16_t deviceAddress, uint16_t memoryAddress, const uint8_t* data, uint16_t size) -> HAL_StatusTypeDef = 0;
+    virtual auto memRead(uint16_t deviceAddress, uint16_t memoryAddress, uint8_t* data, uint16_t size) -> HAL_StatusTypeDef = 0;
+    // Address only transfer, HAL_OK when the device acknowledges
+    virtual auto probe(uint16_t deviceAddress) -> HAL_StatusTypeDef = 0;
+    // Bus clock from HAL_I2C_Init(), ignored by transports with a fixed clock
+    virtual void setSpeed(uint32_t) {
+    }
+};
+
+// Lines of a bus as seen through GPIO ports, used by the bus recovery
+class HostPins {
+public:
+    virtual ~HostPins() = default;
+    virtual void writePin(uint16_t pin, bool level) = 0;
+    virtual auto readPin(uint16_t pin) -> bool = 0;
+};
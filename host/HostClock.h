@@ -0,0 +1,47 @@
+#pragma once
+#include <stdint.h>
+#include <chrono>
+#include <thread>
+
+// Time of the host build. HAL_GetTick(), HAL_Delay(), __WFI() and the DWT
+// cycle counter are derived from it. Virtual by default: simulated transfers
+// advance it. In real time mode, used with real buses, it follows the
+// monotonic clock and advancing it sleeps.
+class HostClock {
+public:
+    static auto now() -> uint64_t {
+        if(sRealTime) {
+            return sMicroseconds + getMonotonicMicroseconds() - sRealTimeStart;
+        }
+        return sMicroseconds;
+    }
+
+    static void advance(uint64_t microseconds) {
+        if(sRealTime) {
+            std::this_thread::sleep_for(std::chrono::microseconds(microseconds));
+            return;
+        }
+        sMicroseconds += microseconds;
+    }
+
+    static void set(uint64_t microseconds) {
+        sMicroseconds = microseconds;
+        sRealTimeStart = getMonotonicMicroseconds();
+    }
+
+    static void useRealTime(bool enable) {
+        sMicroseconds = now();
+        sRealTimeStart = getMonotonicMicroseconds();
+        sRealTime = enable;
+    }
+
+private:
+    static auto getMonotonicMicroseconds() -> uint64_t {
+        auto time = std::chrono::steady_clock::now().time_since_epoch();
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(time).count());
+    }
+
+    static inline uint64_t sMicroseconds{};
+    static inline uint64_t sRealTimeStart{};
+    static inline bool sRealTime{};
+};
@@ -0,0 +1,174 @@
+#include "main.h"
+#include "HostBus.h"
+#include "HostClock.h"
+
+DWT_Type HostDWT;
+CoreDebug_Type HostCoreDebug;
+uint32_t SystemCoreClock = 72000000;
+
+static auto getBus(I2C_HandleTypeDef* hi2c) {
+    return static_cast<HostBus*>(hi2c->Instance);
+}
+
+static void syncCycleCounter() {
+    HostDWT.CYCCNT = static_cast<uint32_t>(HostClock::now() * (SystemCoreClock / 1000000));
+}
+
+static auto finish(I2C_HandleTypeDef* hi2c, HAL_StatusTypeDef status) {
+    hi2c->ErrorCode = status == HAL_OK ? HAL_I2C_ERROR_NONE : HAL_I2C_ERROR_AF;
+    syncCycleCounter();
+    return status;
+}
+
+// Interrupt and DMA transfers complete before returning: the start reports
+// HAL_OK and a failure is left in ErrorCode like the HAL error callback does
+static auto finishAsync(I2C_HandleTypeDef* hi2c, HAL_StatusTypeDef status) {
+    if(status == HAL_BUSY) {
+        return status;
+    }
+    finish(hi2c, status);
+    return HAL_OK;
+}
+
+static auto isReady(I2C_HandleTypeDef* hi2c) {
+    return hi2c->State == HAL_I2C_STATE_READY || hi2c->State == HAL_I2C_STATE_RESET;
+}
+
+extern "C" {
+
+HAL_StatusTypeDef HAL_I2C_Init(I2C_HandleTypeDef* hi2c) {
+    if(hi2c->Init.Timing != 0) {
+        getBus(hi2c)->setSpeed(hi2c->Init.Timing);
+    }
+    hi2c->State = HAL_I2C_STATE_READY;
+    hi2c->ErrorCode = HAL_I2C_ERROR_NONE;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_I2C_DeInit(I2C_HandleTypeDef* hi2c) {
+    hi2c->State = HAL_I2C_STATE_RESET;
+    return HAL_OK;
+}
+
+void HAL_GPIO_Init(GPIO_TypeDef*, GPIO_InitTypeDef*) {
+}
+
+void HAL_GPIO_WritePin(GPIO_TypeDef* GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState) {
+    if(GPIOx->Instance != nullptr) {
+        static_cast<HostPins*>(GPIOx->Instance)->writePin(GPIO_Pin, PinState == GPIO_PIN_SET);
+    }
+}
+
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef* GPIOx, uint16_t GPIO_Pin) {
+    if(GPIOx->Instance == nullptr) {
+        return GPIO_PIN_SET;
+    }
+    return static_cast<HostPins*>(GPIOx->Instance)->readPin(GPIO_Pin) ? GPIO_PIN_SET : GPIO_PIN_RESET;
+}
+
+HAL_StatusTypeDef HAL_I2C_Mem_Write(I2C_HandleTypeDef* hi2c, uint16_t DevAddress, uint16_t MemAddress, uint16_t, uint8_t* pData, uint16_t Size, uint32_t) {
+    if(!isReady(hi2c)) {
+        return HAL_BUSY;
+    }
+    return finish(hi2c, getBus(hi2c)->memWrite(DevAddress, MemAddress, pData, Size));
+}
+
+HAL_StatusTypeDef HAL_I2C_Mem_Read(I2C_HandleTypeDef* hi2c, uint16_t DevAddress, uint16_t MemAddress, uint16_t, uint8_t* pData, uint16_t Size, uint32_t) {
+    if(!isReady(hi2c)) {
+        return HAL_BUSY;
+    }
+    return finish(hi2c, getBus(hi2c)->memRead(DevAddress, MemAddress, pData, Size));
+}
+
+HAL_StatusTypeDef HAL_I2C_Mem_Write_IT(I2C_HandleTypeDef* hi2c, uint16_t DevAddress, uint16_t MemAddress, uint16_t MemAddSize, uint8_t* pData, uint16_t Size) {
+    return finishAsync(hi2c, HAL_I2C_Mem_Write(hi2c, DevAddress, MemAddress, MemAddSize, pData, Size, 0));
+}
+
+HAL_StatusTypeDef HAL_I2C_Mem_Read_IT(I2C_HandleTypeDef* hi2c, uint16_t DevAddress, uint16_t MemAddress, uint16_t MemAddSize, uint8_t* pData, uint16_t Size) {
+    return finishAsync(hi2c, HAL_I2C_Mem_Read(hi2c, DevAddress, MemAddress, MemAddSize, pData, Size, 0));
+}
+
+HAL_StatusTypeDef HAL_I2C_Mem_Write_DMA(I2C_HandleTypeDef* hi2c, uint16_t DevAddress, uint16_t MemAddress, uint16_t MemAddSize, uint8_t* pData, uint16_t Size) {
+    return HAL_I2C_Mem_Write_IT(hi2c, DevAddress, MemAddress, MemAddSize, pData, Size);
+}
+
+HAL_StatusTypeDef HAL_I2C_Mem_Read_DMA(I2C_HandleTypeDef* hi2c, uint16_t DevAddress, uint16_t MemAddress, uint16_t MemAddSize, uint8_t* pData, uint16_t Size) {
+    return HAL_I2C_Mem_Read_IT(hi2c, DevAddress, MemAddress, MemAddSize, pData, Size);
+}
+
+HAL_StatusTypeDef HAL_I2C_IsDeviceReady(I2C_HandleTypeDef* hi2c, uint16_t DevAddress, uint32_t Trials, uint32_t) {
+    if(!isReady(hi2c)) {
+        return HAL_BUSY;
+    }
+    for(uint32_t trial = 0; trial < Trials; ++trial) {
+        if(getBus(hi2c)->probe(DevAddress) == HAL_OK) {
+            return finish(hi2c, HAL_OK);
+        }
+    }
+    return finish(hi2c, HAL_ERROR);
+}
+
+HAL_StatusTypeDef HAL_I2C_Master_Abort_IT(I2C_HandleTypeDef* hi2c, uint16_t) {
+    hi2c->State = HAL_I2C_STATE_READY;
+    return HAL_OK;
+}
+
+HAL_I2C_StateTypeDef HAL_I2C_GetState(I2C_HandleTypeDef* hi2c) {
+    return isReady(hi2c) ? HAL_I2C_STATE_READY : hi2c->State;
+}
+
+uint32_t HAL_I2C_GetError(I2C_HandleTypeDef* hi2c) {
+    return hi2c->ErrorCode;
+}
+
+// Reset configuration of the STM32 CRC unit: CRC-32/MPEG-2 over 32-bit words
+uint32_t HAL_CRC_Calculate(CRC_HandleTypeDef*, uint32_t pBuffer[], uint32_t BufferLength) {
+    static uint32_t table[256];
+    if(table[1] == 0) {
+        for(uint32_t i = 0; i < 256; ++i) {
+            auto value = i << 24;
+            for(auto bit = 0; bit < 8; ++bit) {
+                value = (value & 0x80000000U) ? (value << 1) ^ 0x04C11DB7U : value << 1;
+            }
+            table[i] = value;
+        }
+    }
+    uint32_t crc = 0xFFFFFFFFU;
+    for(uint32_t i = 0; i < BufferLength; ++i) {
+        auto word = pBuffer[i];
+        for(auto shift = 24; shift >= 0; shift -= 8) {
+            crc = (crc << 8) ^ table[((crc >> 24) ^ (word >> shift)) & 0xFF];
+        }
+    }
+    return crc;
+}
+
+void HAL_RTCEx_BKUPWrite(RTC_HandleTypeDef* hrtc, uint32_t BackupRegister, uint32_t Data) {
+    static_cast<uint32_t*>(hrtc->Instance)[BackupRegister] = Data;
+}
+
+uint32_t HAL_RTCEx_BKUPRead(RTC_HandleTypeDef* hrtc, uint32_t BackupRegister) {
+    return static_cast<uint32_t*>(hrtc->Instance)[BackupRegister];
+}
+
+uint32_t HAL_GetTick(void) {
+    return static_cast<uint32_t>(HostClock::now() / 1000);
+}
+
+void HAL_Delay(uint32_t Delay) {
+    // HAL_Delay waits one extra tick to guarantee the minimum delay
+    HostClock::advance((Delay + 1) * 1000ull);
+    syncCycleCounter();
+}
+
+uint32_t ITM_SendChar(uint32_t ch) {
+    return ch;
+}
+
+// Sleeps until the next SysTick interrupt
+void __WFI(void) {
+    HostClock::advance(1000 - HostClock::now() % 1000);
+    syncCycleCounter();
+}
+
+}
@@ -0,0 +1,81 @@
+#include "LinuxI2CBus.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/i2c-dev.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#include <cstring>
+
+LinuxI2CAdapter::LinuxI2CAdapter(const char* path)
+    : mFile(open(path, O_RDWR | O_CLOEXEC)) {
+}
+
+LinuxI2CAdapter::~LinuxI2CAdapter() {
+    if(mFile >= 0) {
+        close(mFile);
+    }
+}
+
+auto LinuxI2CAdapter::transfer(i2c_msg* messages, uint32_t count) -> int {
+    i2c_rdwr_ioctl_data request{messages, count};
+    if(ioctl(mFile, I2C_RDWR, &request) < 0) {
+        return -errno;
+    }
+    return 0;
+}
+
+LinuxI2CBus::LinuxI2CBus(I2CTransport& transport)
+    : mTransport(transport) {
+}
+
+// The driver never writes more than a page, larger writes are refused
+auto LinuxI2CBus::memWrite(uint16_t deviceAddress, uint16_t memoryAddress, const uint8_t* data, uint16_t size) -> HAL_StatusTypeDef {
+    if(size > sMaxWriteSize) {
+        return HAL_ERROR;
+    }
+    mWriteBuffer[0] = static_cast<uint8_t>(memoryAddress >> 8);
+    mWriteBuffer[1] = static_cast<uint8_t>(memoryAddress);
+    memcpy(mWriteBuffer + 2, data, size);
+    i2c_msg message{static_cast<uint16_t>(deviceAddress >> 1), 0, static_cast<uint16_t>(size + 2), mWriteBuffer};
+    return execute(&message, 1);
+}
+
+auto LinuxI2CBus::memRead(uint16_t deviceAddress, uint16_t memoryAddress, uint8_t* data, uint16_t size) -> HAL_StatusTypeDef {
+    if(size > sMaxReadSize) {
+        return HAL_ERROR;
+    }
+    uint8_t address[2]{static_cast<uint8_t>(memoryAddress >> 8), static_cast<uint8_t>(memoryAddress)};
+    i2c_msg messages[2]{
+        {static_cast<uint16_t>(deviceAddress >> 1), 0, sizeof(address), address},
+        {static_cast<uint16_t>(deviceAddress >> 1), I2C_M_RD, size, data}
+    };
+    return execute(messages, 2);
+}
+
+// Zero length write, the quick command of SMBus
+auto LinuxI2CBus::probe(uint16_t deviceAddress) -> HAL_StatusTypeDef {
+    i2c_msg message{static_cast<uint16_t>(deviceAddress >> 1), 0, 0, mWriteBuffer};
+    return execute(&message, 1);
+}
+
+auto LinuxI2CBus::execute(i2c_msg* messages, uint32_t count) -> HAL_StatusTypeDef {
+    ++mTransfers;
+    mLastError = mTransport.transfer(messages, count);
+    switch(mLastError) {
+        case 0:
+            return HAL_OK;
+        // Adapters report a missing ACK with one of these
+        case -EREMOTEIO:
+        case -ENXIO:
+        case -EIO:
+            ++mNacks;
+            return HAL_ERROR;
+        case -ETIMEDOUT:
+            return HAL_TIMEOUT;
+        case -EAGAIN:
+        case -EBUSY:
+            return HAL_BUSY;
+        default:
+            return HAL_ERROR;
+    }
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include "HostBus.h"
+#include <linux/i2c.h>
+
+// Executes one I2C_RDWR request: the messages run as a single combined
+// transaction with repeated STARTs and one STOP. Returns 0 or -errno.
+class I2CTransport {
+public:
+    virtual ~I2CTransport() = default;
+    virtual auto transfer(i2c_msg* messages, uint32_t count) -> int = 0;
+};
+
+// Kernel adapter behind /dev/i2c-N, one ioctl per transfer
+class LinuxI2CAdapter : public I2CTransport {
+public:
+    explicit LinuxI2CAdapter(const char* path);
+    ~LinuxI2CAdapter() override;
+
+    auto isOpen() const -> bool {
+        return mFile >= 0;
+    }
+
+    auto transfer(i2c_msg* messages, uint32_t count) -> int override;
+
+private:
+    int mFile;
+};
+
+// HostBus over I2C_RDWR. A memory read is the address write and the data read
+// combined in one request, a memory write is one message with the address in
+// front, so every HAL call costs one system call. The kernel refuses messages
+// over 8192 bytes, a larger read is refused here like a write over a page.
+class LinuxI2CBus : public HostBus {
+    static constexpr uint16_t sMaxWriteSize = 256;
+    static constexpr uint16_t sMaxReadSize = 8192;
+public:
+    explicit LinuxI2CBus(I2CTransport& transport);
+
+    auto memWrite(uint16_t deviceAddress, uint16_t memoryAddress, const uint8_t* data, uint16_t size) -> HAL_StatusTypeDef override;
+    auto memRead(uint16_t deviceAddress, uint16_t memoryAddress, uint8_t* data, uint16_t size) -> HAL_StatusTypeDef override;
+    auto probe(uint16_t deviceAddress) -> HAL_StatusTypeDef override;
+
+    auto getTransfers() const -> uint64_t {
+        return mTransfers;
+    }
+
+    auto getNacks() const -> uint64_t {
+        return mNacks;
+    }
+
+    auto getLastError() const -> int {
+        return mLastError;
+    }
+
+private:
+    auto execute(i2c_msg* messages, uint32_t count) -> HAL_StatusTypeDef;
+
+    I2CTransport& mTransport;
+    uint8_t mWriteBuffer[2 + sMaxWriteSize]{};
+    uint64_t mTransfers{};
+    uint64_t mNacks{};
+    int mLastError{};
+};
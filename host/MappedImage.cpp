@@ -0,0 +1,47 @@
+#include "MappedImage.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// A trailing partial device is left out
+MappedImage::MappedImage(const char* path, uint32_t deviceCapacity, uint16_t pageSize, bool isWritable, 
+                         uint32_t writeCycleMicroseconds) {
+    auto file = open(path, (isWritable ? O_RDWR : O_RDONLY) | O_CLOEXEC);
+    if(file < 0) {
+        return;
+    }
+    struct stat status{};
+    auto count = fstat(file, &status) == 0 && deviceCapacity != 0 ? status.st_size / deviceCapacity : 0;
+    if(count > 0) {
+        mSize = static_cast<size_t>(count) * deviceCapacity;
+        auto memory = mmap(nullptr, mSize, PROT_READ | PROT_WRITE, isWritable ? MAP_SHARED : MAP_PRIVATE, file, 0);
+        mMemory = memory == MAP_FAILED ? nullptr : static_cast<uint8_t*>(memory);
+    }
+    // The mapping keeps the file referenced
+    close(file);
+    if(mMemory == nullptr) {
+        return;
+    }
+    mDevices.reserve(count);
+    for(off_t i = 0; i < count; ++i) {
+        mDevices.push_back(std::make_unique<DeviceModel>(mMemory + i * deviceCapacity, deviceCapacity, pageSize, 
+                                                         writeCycleMicroseconds));
+    }
+}
+
+MappedImage::~MappedImage() {
+    if(mMemory != nullptr) {
+        munmap(mMemory, mSize);
+    }
+}
+
+void MappedImage::adviseSequential() {
+    if(mMemory != nullptr) {
+        madvise(mMemory, mSize, MADV_SEQUENTIAL);
+    }
+}
+
+auto MappedImage::sync() -> bool {
+    return mMemory != nullptr && msync(mMemory, mSize, MS_SYNC) == 0;
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include "DeviceModel.h"
+#include <memory>
+#include <vector>
+
+// Image file holding the contents of many devices back to back, mapped into
+// memory. Every device is a DeviceModel working directly on its slice of the
+// mapping, the page cache does the I/O and nothing is copied. Writes go to the
+// file unless the image is opened read-only, then they stay private to the process.
+class MappedImage {
+public:
+    MappedImage(const char* path, uint32_t deviceCapacity, uint16_t pageSize, bool isWritable, 
+                uint32_t writeCycleMicroseconds = 0);
+    ~MappedImage();
+
+    MappedImage(const MappedImage&) = delete;
+    auto operator=(const MappedImage&) -> MappedImage& = delete;
+
+    auto isOpen() const -> bool {
+        return mMemory != nullptr;
+    }
+
+    auto getDeviceCount() const -> uint32_t {
+        return static_cast<uint32_t>(mDevices.size());
+    }
+
+    auto getDevice(uint32_t index) -> DeviceModel& {
+        return *mDevices[index];
+    }
+
+    // Hints the kernel that the devices are processed in order, one after another
+    void adviseSequential();
+    // Writes the modified pages back to the file
+    auto sync() -> bool;
+
+private:
+    uint8_t* mMemory{};
+    size_t mSize{};
+    std::vector<std::unique_ptr<DeviceModel>> mDevices;
+};
@@ -0,0 +1,125 @@
+#include "SimulatedBus.h"
+#include "HostClock.h"
+
+// Device address, two memory address bytes, the read repeats the device address
+static constexpr uint32_t sWriteOverhead = 3;
+static constexpr uint32_t sReadOverhead = 4;
+// Eight data bits and ACK per byte
+static constexpr uint32_t sBitsPerByte = 9;
+
+SimulatedBus::SimulatedBus(uint32_t speedHz) 
+    : mSpeedHz(speedHz) {
+}
+
+void SimulatedBus::attach(uint16_t deviceAddress, DeviceModel& device) {
+    for(uint8_t i = 0; i < mCount; ++i) {
+        if(mAddresses[i] == deviceAddress) {
+            mDevices[i] = &device;
+            return;
+        }
+    }
+    if(mCount < sMaxDevices) {
+        mAddresses[mCount] = deviceAddress;
+        mDevices[mCount++] = &device;
+    }
+}
+
+void SimulatedBus::setSpeed(uint32_t speedHz) {
+    mSpeedHz = speedHz;
+}
+
+auto SimulatedBus::memWrite(uint16_t deviceAddress, uint16_t memoryAddress, const uint8_t* data, uint16_t size) -> HAL_StatusTypeDef {
+    if(mHeldClocks != 0) {
+        return HAL_BUSY;
+    }
+    auto device = find(deviceAddress);
+    if(device == nullptr || device->isBusy(HostClock::now())) {
+        transfer(1);
+        return acknowledge(false);
+    }
+    transfer(sWriteOverhead + size);
+    if(!device->supportsSpeed(mSpeedHz)) {
+        return acknowledge(false);
+    }
+    // The write cycle starts with the STOP condition
+    return acknowledge(device->write(memoryAddress, data, size, HostClock::now()));
+}
+
+auto SimulatedBus::memRead(uint16_t deviceAddress, uint16_t memoryAddress, uint8_t* data, uint16_t size) -> HAL_StatusTypeDef {
+    if(mHeldClocks != 0) {
+        return HAL_BUSY;
+    }
+    auto device = find(deviceAddress);
+    if(device == nullptr || device->isBusy(HostClock::now())) {
+        transfer(1);
+        return acknowledge(false);
+    }
+    transfer(sReadOverhead + size);
+    if(!device->supportsSpeed(mSpeedHz)) {
+        return acknowledge(false);
+    }
+    return acknowledge(device->read(memoryAddress, data, size, HostClock::now()));
+}
+
+auto SimulatedBus::probe(uint16_t deviceAddress) -> HAL_StatusTypeDef {
+    if(mHeldClocks != 0) {
+        return HAL_BUSY;
+    }
+    transfer(1);
+    auto device = find(deviceAddress);
+    return acknowledge(device != nullptr && !device->isBusy(HostClock::now()));
+}
+
+void SimulatedBus::setPins(uint16_t sclPin, uint16_t sdaPin) {
+    mSclPin = sclPin;
+    mSdaPin = sdaPin;
+}
+
+void SimulatedBus::holdSda(uint8_t clocks) {
+    mHeldClocks = clocks;
+}
+
+void SimulatedBus::writePin(uint16_t pin, bool level) {
+    if(pin == mSclPin) {
+        // The slave shifts out the next bit on every rising edge
+        if(level && !mScl && mHeldClocks != 0) {
+            --mHeldClocks;
+        }
+        mScl = level;
+    }
+    if(pin == mSdaPin) {
+        mSda = level;
+    }
+}
+
+auto SimulatedBus::readPin(uint16_t pin) -> bool {
+    if(pin == mSclPin) {
+        return mScl;
+    }
+    return pin == mSdaPin && mSda && mHeldClocks == 0;
+}
+
+auto SimulatedBus::find(uint16_t deviceAddress) const -> DeviceModel* {
+    for(uint8_t i = 0; i < mCount; ++i) {
+        if(mAddresses[i] == deviceAddress) {
+            return mDevices[i];
+        }
+    }
+    return nullptr;
+}
+
+void SimulatedBus::transfer(uint32_t bytes) {
+    // START and STOP take about one bit time each
+    auto microseconds = ((bytes * sBitsPerByte + 2) * 1000000ull + mSpeedHz - 1) / mSpeedHz;
+    HostClock::advance(microseconds);
+    mBusMicroseconds += microseconds;
+    ++mTransfers;
+}
+
+auto SimulatedBus::acknowledge(bool acknowledged) -> HAL_StatusTypeDef {
+    if(!acknowledged) {
+        ++mNacks;
+        return HAL_ERROR;
+    }
+    return HAL_OK;
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include "HostBus.h"
+#include "DeviceModel.h"
+
+// Bus with simulated devices, every transfer advances HostClock by its duration.
+// Its lines can be wired to GPIO ports to model a slave that holds SDA low.
+class SimulatedBus : public HostBus, public HostPins {
+    static constexpr uint8_t sMaxDevices = 8;
+public:
+    explicit SimulatedBus(uint32_t speedHz = 400000);
+
+    void attach(uint16_t deviceAddress, DeviceModel& device);
+    void setSpeed(uint32_t speedHz) override;
+
+    auto memWrite(uint16_t deviceAddress, uint16_t memoryAddress, const uint8_t* data, uint16_t size) -> HAL_StatusTypeDef override;
+    auto memRead(uint16_t deviceAddress, uint16_t memoryAddress, uint8_t* data, uint16_t size) -> HAL_StatusTypeDef override;
+    auto probe(uint16_t deviceAddress) -> HAL_StatusTypeDef override;
+
+    void setPins(uint16_t sclPin, uint16_t sdaPin);
+    // A slave reset in the middle of a read keeps SDA low for the rest of its byte,
+    // the peripheral sees a busy bus until SCL is clocked that many times
+    void holdSda(uint8_t clocks);
+    void writePin(uint16_t pin, bool level) override;
+    auto readPin(uint16_t pin) -> bool override;
+
+    auto getBusMicroseconds() const -> uint64_t {
+        return mBusMicroseconds;
+    }
+
+    auto getTransfers() const -> uint64_t {
+        return mTransfers;
+    }
+
+    auto getNacks() const -> uint64_t {
+        return mNacks;
+    }
+
+private:
+    auto find(uint16_t deviceAddress) const -> DeviceModel*;
+    void transfer(uint32_t bytes);
+    auto acknowledge(bool acknowledged) -> HAL_StatusTypeDef;
+
+    uint16_t mAddresses[sMaxDevices]{};
+    DeviceModel* mDevices[sMaxDevices]{};
+    uint8_t mCount{};
+    uint32_t mSpeedHz;
+    uint64_t mBusMicroseconds{};
+    uint64_t mTransfers{};
+    uint64_t mNacks{};
+    uint16_t mSclPin{};
+    uint16_t mSdaPin{};
+    bool mScl{true};
+    bool mSda{true};
+    uint8_t mHeldClocks{};
+};
@@ -0,0 +1,128 @@
+// Host stand-in for the CubeMX main.h: the subset of the STM32 HAL and CMSIS
+// used by the driver, so the driver sources build unchanged for host tools.
+// I2C_HandleTypeDef::Instance points to a HostBus implementation,
+// RTC_HandleTypeDef::Instance to RTC_BKP_NUMBER backup registers.
+// I2C_InitTypeDef::Timing holds the bus clock in Hz instead of a TIMINGR value.
+// GPIO_TypeDef::Instance points to a HostPins implementation, pins read high without one.
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+  HAL_OK = 0x00U,
+  HAL_ERROR = 0x01U,
+  HAL_BUSY = 0x02U,
+  HAL_TIMEOUT = 0x03U
+} HAL_StatusTypeDef;
+
+typedef enum {
+  HAL_I2C_STATE_RESET = 0x00U,
+  HAL_I2C_STATE_READY = 0x20U,
+  HAL_I2C_STATE_BUSY = 0x24U,
+  HAL_I2C_STATE_BUSY_TX = 0x21U,
+  HAL_I2C_STATE_BUSY_RX = 0x22U
+} HAL_I2C_StateTypeDef;
+
+#define HAL_I2C_ERROR_NONE 0x00000000U
+#define HAL_I2C_ERROR_BERR 0x00000001U
+#define HAL_I2C_ERROR_ARLO 0x00000002U
+#define HAL_I2C_ERROR_AF 0x00000004U
+#define HAL_I2C_ERROR_OVR 0x00000008U
+#define HAL_I2C_ERROR_DMA 0x00000010U
+#define HAL_I2C_ERROR_TIMEOUT 0x00000020U
+
+#define I2C_MEMADD_SIZE_8BIT 0x00000001U
+#define I2C_MEMADD_SIZE_16BIT 0x00000002U
+
+typedef struct {
+  uint32_t Timing;
+} I2C_InitTypeDef;
+
+typedef struct {
+  void* Instance;
+  I2C_InitTypeDef Init;
+  volatile HAL_I2C_StateTypeDef State;
+  volatile uint32_t ErrorCode;
+} I2C_HandleTypeDef;
+
+typedef struct {
+  void* Instance;
+} CRC_HandleTypeDef;
+
+typedef struct {
+  void* Instance;
+} RTC_HandleTypeDef;
+
+#define RTC_BKP_NUMBER 20U
+
+typedef struct {
+  void* Instance;
+} GPIO_TypeDef;
+
+typedef enum {
+  GPIO_PIN_RESET = 0U,
+  GPIO_PIN_SET
+} GPIO_PinState;
+
+typedef struct {
+  uint32_t Pin;
+  uint32_t Mode;
+  uint32_t Pull;
+  uint32_t Speed;
+  uint32_t Alternate;
+} GPIO_InitTypeDef;
+
+#define GPIO_MODE_INPUT 0x00000000U
+#define GPIO_MODE_OUTPUT_OD 0x00000011U
+#define GPIO_NOPULL 0x00000000U
+#define GPIO_SPEED_FREQ_LOW 0x00000000U
+
+HAL_StatusTypeDef HAL_I2C_Init(I2C_HandleTypeDef* hi2c);
+HAL_StatusTypeDef HAL_I2C_DeInit(I2C_HandleTypeDef* hi2c);
+HAL_StatusTypeDef HAL_I2C_Mem_Write(I2C_HandleTypeDef* hi2c, uint16_t DevAddress, uint16_t MemAddress, uint16_t MemAddSize, uint8_t* pData, uint16_t Size, uint32_t Timeout);
+HAL_StatusTypeDef HAL_I2C_Mem_Read(I2C_HandleTypeDef* hi2c, uint16_t DevAddress, uint16_t MemAddress, uint16_t MemAddSize, uint8_t* pData, uint16_t Size, uint32_t Timeout);
+HAL_StatusTypeDef HAL_I2C_Mem_Write_IT(I2C_HandleTypeDef* hi2c, uint16_t DevAddress, uint16_t MemAddress, uint16_t MemAddSize, uint8_t* pData, uint16_t Size);
+HAL_StatusTypeDef HAL_I2C_Mem_Read_IT(I2C_HandleTypeDef* hi2c, uint16_t DevAddress, uint16_t MemAddress, uint16_t MemAddSize, uint8_t* pData, uint16_t Size);
+HAL_StatusTypeDef HAL_I2C_Mem_Write_DMA(I2C_HandleTypeDef* hi2c, uint16_t DevAddress, uint16_t MemAddress, uint16_t MemAddSize, uint8_t* pData, uint16_t Size);
+HAL_StatusTypeDef HAL_I2C_Mem_Read_DMA(I2C_HandleTypeDef* hi2c, uint16_t DevAddress, uint16_t MemAddress, uint16_t MemAddSize, uint8_t* pData, uint16_t Size);
+HAL_StatusTypeDef HAL_I2C_IsDeviceReady(I2C_HandleTypeDef* hi2c, uint16_t DevAddress, uint32_t Trials, uint32_t Timeout);
+HAL_StatusTypeDef HAL_I2C_Master_Abort_IT(I2C_HandleTypeDef* hi2c, uint16_t DevAddress);
+HAL_I2C_StateTypeDef HAL_I2C_GetState(I2C_HandleTypeDef* hi2c);
+uint32_t HAL_I2C_GetError(I2C_HandleTypeDef* hi2c);
+uint32_t HAL_CRC_Calculate(CRC_HandleTypeDef* hcrc, uint32_t pBuffer[], uint32_t BufferLength);
+void HAL_RTCEx_BKUPWrite(RTC_HandleTypeDef* hrtc, uint32_t BackupRegister, uint32_t Data);
+uint32_t HAL_RTCEx_BKUPRead(RTC_HandleTypeDef* hrtc, uint32_t BackupRegister);
+void HAL_GPIO_Init(GPIO_TypeDef* GPIOx, GPIO_InitTypeDef* GPIO_Init);
+void HAL_GPIO_WritePin(GPIO_TypeDef* GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState);
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef* GPIOx, uint16_t GPIO_Pin);
+uint32_t HAL_GetTick(void);
+void HAL_Delay(uint32_t Delay);
+
+typedef struct {
+  volatile uint32_t CTRL;
+  volatile uint32_t CYCCNT;
+} DWT_Type;
+
+typedef struct {
+  volatile uint32_t DEMCR;
+} CoreDebug_Type;
+
+extern DWT_Type HostDWT;
+extern CoreDebug_Type HostCoreDebug;
+extern uint32_t SystemCoreClock;
+
+#define DWT (&HostDWT)
+#define CoreDebug (&HostCoreDebug)
+#define DWT_CTRL_CYCCNTENA_Msk 0x00000001U
+#define CoreDebug_DEMCR_TRCENA_Msk 0x01000000U
+
+uint32_t ITM_SendChar(uint32_t ch);
+void __WFI(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,402 @@
+// Runs years of a periodic write pattern through the real driver against a
+// simulated device that wears out, and projects the lifetime of the records.
+// Time is compressed: the clock jumps from one write to the next, the host
+// only pays for the transfers. Scenarios run in parallel processes because
+// the driver keeps its state in globals.
+// Build: g++ -std=c++17 -O2 -I.. -I../host ../EEPROM.cpp ../EEPROM_Trace.cpp ../EEPROM_Capture.cpp
+//        ../host/*.cpp eeprom_endurance.cpp -o eeprom_endurance
+// Usage: eeprom_endurance [-j jobs] [scenario...]
+// A scenario is a comma separated list of key=value:
+//   records=4  size=32 (bytes)  period=60 (s)  years=10  page=64  slots=1
+//   cache=0 (s)  endurance=2000000  spread=0.3  retention=1 (years)
+//   scale=1  verify=86400 (s)  seed=1  image=<path>
+// slots rotates every record over several locations, cache keeps updates in
+// RAM and writes the dirty records once per interval. scale counts every
+// write cycle as several, a faster and coarser run. endurance is the median
+// of the cells, the datasheet figure is a minimum that the weak cells barely reach.
+// image maps a file of 32 KiB devices back to back and spreads the records
+// over its first EEPROM_MAX_DEVICES slices. The mapping is private, the file
+// keeps its contents and every scenario starts from them.
+#include "EEPROM.h"
+#include "HostClock.h"
+#include "MappedImage.h"
+#include "SimulatedBus.h"
+#include <sys/wait.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct Scenario {
+    std::string name;
+    uint16_t records = 4;
+    uint16_t size = 32;
+    uint32_t periodSeconds = 60;
+    double years = 10;
+    uint16_t pageSize = 64;
+    uint16_t slots = 1;
+    uint32_t cacheSeconds = 0;
+    uint32_t enduranceCycles = 2000000;
+    double enduranceSpread = 0.3;
+    double retentionYears = 1;
+    uint32_t wearScale = 1;
+    uint32_t verifySeconds = 86400;
+    uint32_t seed = 1;
+    std::string image;
+};
+
+// Sent from the worker process through a pipe, keep it trivially copyable
+struct Result {
+    uint8_t isValid;
+    uint8_t isFailed;
+    double failureYears;
+    double wearOutYears;
+    double simulatedYears;
+    uint64_t writes;
+    uint64_t writeCycles;
+    uint32_t maxCellWrites;
+    uint32_t stuckCells;
+    uint32_t failedReads;
+    double hostSeconds;
+};
+
+static constexpr double sSecondsPerYear = 365.25 * 24 * 3600;
+static constexpr uint32_t sCapacity = 32768;
+static constexpr uint16_t sDevicePageSize = 64;
+
+static auto parseScenario(const std::string& text) -> Scenario {
+    Scenario scenario;
+    scenario.name = text;
+    size_t start = 0;
+    while(start < text.size()) {
+        auto end = text.find(',', start);
+        auto item = text.substr(start, end == std::string::npos ? std::string::npos : end - start);
+        start = end == std::string::npos ? text.size() : end + 1;
+        auto separator = item.find('=');
+        if(separator == std::string::npos) {
+            continue;
+        }
+        auto key = item.substr(0, separator);
+        auto value = item.substr(separator + 1);
+        auto number = strtod(value.c_str(), nullptr);
+        if(key == "image") {
+            scenario.image = value;
+            continue;
+        }
+        if(key == "records") {
+            scenario.records = static_cast<uint16_t>(number);
+        } else if(key == "size") {
+            scenario.size = static_cast<uint16_t>(number);
+        } else if(key == "period") {
+            scenario.periodSeconds = static_cast<uint32_t>(number);
+        } else if(key == "years") {
+            scenario.years = number;
+        } else if(key == "page") {
+            scenario.pageSize = static_cast<uint16_t>(number);
+        } else if(key == "slots") {
+            scenario.slots = std::max<uint16_t>(1, static_cast<uint16_t>(number));
+        } else if(key == "cache") {
+            scenario.cacheSeconds = static_cast<uint32_t>(number);
+        } else if(key == "endurance") {
+            scenario.enduranceCycles = static_cast<uint32_t>(number);
+        } else if(key == "spread") {
+            scenario.enduranceSpread = number;
+        } else if(key == "retention") {
+            scenario.retentionYears = number;
+        } else if(key == "scale") {
+            scenario.wearScale = std::max<uint32_t>(1, static_cast<uint32_t>(number));
+        } else if(key == "verify") {
+            scenario.verifySeconds = static_cast<uint32_t>(number);
+        } else if(key == "seed") {
+            scenario.seed = static_cast<uint32_t>(number);
+        } else {
+            fprintf(stderr, "unknown key %s\n", key.c_str());
+        }
+    }
+    return scenario;
+}
+
+class Simulation {
+public:
+    explicit Simulation(const Scenario& scenario)
+        : mScenario(scenario) {
+    }
+
+    auto run() -> Result {
+        Result result{};
+        if(!setup()) {
+            return result;
+        }
+        result.isValid = 1;
+        auto hostStart = std::chrono::steady_clock::now();
+        auto horizon = static_cast<uint64_t>(mScenario.years * sSecondsPerYear);
+        auto period = std::max<uint32_t>(1, mScenario.periodSeconds);
+        auto flushPeriod = mScenario.cacheSeconds;
+        uint64_t nextUpdate = 0;
+        uint64_t nextFlush = flushPeriod;
+        uint64_t nextVerify = mScenario.verifySeconds;
+        uint16_t record = 0;
+        // Updates of the records are spread evenly over the period
+        auto updateStep = std::max<uint64_t>(1, period / mScenario.records);
+        while(nextUpdate < horizon && !result.isFailed) {
+            auto now = std::min({nextUpdate, flushPeriod ? nextFlush : UINT64_MAX, mScenario.verifySeconds ? nextVerify : UINT64_MAX});
+            advanceTo(now);
+            if(now == nextUpdate) {
+                update(record);
+                if(flushPeriod == 0) {
+                    result.writes += store(record);
+                }
+                record = (record + 1) % mScenario.records;
+                nextUpdate += record == 0 ? period - updateStep * (mScenario.records - 1) : updateStep;
+            }
+            if(flushPeriod && now == nextFlush) {
+                for(uint16_t i = 0; i < mScenario.records; ++i) {
+                    result.writes += mDirty[i] ? store(i) : 0;
+                }
+                nextFlush += flushPeriod;
+            }
+            if(mScenario.verifySeconds && now == nextVerify) {
+                result.isFailed = !verify(result.failedReads);
+                nextVerify += mScenario.verifySeconds;
+            }
+        }
+        result.isFailed = result.isFailed || !verify(result.failedReads);
+        auto elapsedSeconds = HostClock::now() / 1e6;
+        result.simulatedYears = elapsedSeconds / sSecondsPerYear;
+        result.failureYears = result.isFailed ? result.simulatedYears : 0;
+        result.wearOutYears = projectWearOut(elapsedSeconds);
+        for(auto device : mDevices) {
+            result.writeCycles += device->getWriteCycles();
+            result.stuckCells += device->getStuckCells();
+            for(auto writes : device->getCellWrites()) {
+                result.maxCellWrites = std::max(result.maxCellWrites, writes);
+            }
+        }
+        result.hostSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - hostStart).count();
+        return result;
+    }
+
+private:
+    auto setup() -> bool {
+        WearModel model;
+        model.enduranceCycles = mScenario.enduranceCycles;
+        model.enduranceSpread = mScenario.enduranceSpread;
+        model.retentionMicroseconds = static_cast<uint64_t>(mScenario.retentionYears * sSecondsPerYear * 1e6);
+        model.wearScale = mScenario.wearScale;
+        model.seed = mScenario.seed;
+        if(!setupDevices()) {
+            return false;
+        }
+        HostClock::set(0);
+        for(uint8_t i = 0; i < mDevices.size(); ++i) {
+            mDevices[i]->setWearModel(model);
+            uint16_t address = 0xA0 | (i << 1);
+            mBus.attach(address, *mDevices[i]);
+            auto config = EEPROM_makeDefaultConfig(&mHandle, &mCRC);
+            config.deviceAddress = address;
+            config.pageSize = mScenario.pageSize;
+            if(EEPROM_InitDevice(i, config) != EEPROM_Status_Sucess) {
+                fprintf(stderr, "%s: can't initialize the driver\n", mScenario.name.c_str());
+                return false;
+            }
+        }
+        mPagesPerRecord = EEPROM_getBuffersPagesCount(mScenario.size);
+        auto recordsPerDevice = (mScenario.records + mDevices.size() - 1) / mDevices.size();
+        auto pages = static_cast<uint32_t>(mPagesPerRecord) * mScenario.slots * recordsPerDevice;
+        if(pages * mScenario.pageSize > sCapacity || mScenario.size % 4 != 0) {
+            fprintf(stderr, "%s: records don't fit the device or size isn't a multiple of 4\n", mScenario.name.c_str());
+            return false;
+        }
+        mValues.assign(mScenario.records, std::vector<uint8_t>(mScenario.size));
+        mSequences.assign(mScenario.records, 0);
+        mDirty.assign(mScenario.records, false);
+        srand(mScenario.seed);
+        return true;
+    }
+
+    // Slices of the image, or one device of its own
+    auto setupDevices() -> bool {
+        if(mScenario.image.empty()) {
+            mOwnedDevice = std::make_unique<DeviceModel>(sCapacity, sDevicePageSize);
+            mDevices.push_back(mOwnedDevice.get());
+            return true;
+        }
+        mImage = std::make_unique<MappedImage>(mScenario.image.c_str(), sCapacity, sDevicePageSize, false);
+        if(!mImage->isOpen()) {
+            fprintf(stderr, "%s: can't map %s\n", mScenario.name.c_str(), mScenario.image.c_str());
+            return false;
+        }
+        auto count = std::min<uint32_t>(mImage->getDeviceCount(), EEPROM_MAX_DEVICES);
+        for(uint32_t i = 0; i < count; ++i) {
+            mDevices.push_back(&mImage->getDevice(i));
+        }
+        return true;
+    }
+
+    // Idle time is skipped, only the transfers advance the clock on their own
+    void advanceTo(uint64_t seconds) {
+        auto time = seconds * 1000000ull;
+        if(HostClock::now() < time) {
+            HostClock::set(time);
+        }
+    }
+
+    void update(uint16_t record) {
+        for(auto& byte : mValues[record]) {
+            byte = static_cast<uint8_t>(rand());
+        }
+        mDirty[record] = true;
+    }
+
+    // Record i lives on device i % devices
+    auto getDevice(uint16_t record) const -> uint8_t {
+        return static_cast<uint8_t>(record % mDevices.size());
+    }
+
+    auto getPage(uint16_t record, uint32_t sequence) const -> uint16_t {
+        auto slot = sequence % mScenario.slots;
+        auto index = record / mDevices.size();
+        return static_cast<uint16_t>((index * mScenario.slots + slot) * mPagesPerRecord);
+    }
+
+    auto store(uint16_t record) -> uint64_t {
+        auto buffer = mValues[record];
+        auto page = getPage(record, ++mSequences[record]);
+        EEPROM_WriteDevice(getDevice(record), page, buffer.data(), mScenario.size);
+        mDirty[record] = false;
+        return 1;
+    }
+
+    // The latest copy of every record has to read back intact
+    auto verify(uint32_t& failedReads) -> bool {
+        std::vector<uint8_t> buffer(mScenario.size);
+        auto isIntact = true;
+        for(uint16_t record = 0; record < mScenario.records; ++record) {
+            if(mSequences[record] == 0) {
+                continue;
+            }
+            auto status = EEPROM_ReadDevice(getDevice(record), getPage(record, mSequences[record]), buffer.data(), mScenario.size);
+            // A cached record may legitimately be newer than its stored copy
+            if(status != EEPROM_Status_Sucess || (!mDirty[record] && buffer != mValues[record])) {
+                ++failedReads;
+                isIntact = false;
+            }
+        }
+        return isIntact;
+    }
+
+    // Time until the first written cell reaches its endurance at the rate seen so far
+    auto projectWearOut(double elapsedSeconds) const -> double {
+        auto years = 0.0;
+        for(auto device : mDevices) {
+            auto& writes = device->getCellWrites();
+            auto& endurance = device->getCellEndurance();
+            for(size_t cell = 0; cell < writes.size(); ++cell) {
+                if(writes[cell] == 0) {
+                    continue;
+                }
+                auto cellYears = elapsedSeconds * endurance[cell] / writes[cell] / sSecondsPerYear;
+                years = years == 0 ? cellYears : std::min(years, cellYears);
+            }
+        }
+        return years;
+    }
+
+    const Scenario& mScenario;
+    std::unique_ptr<MappedImage> mImage;
+    std::unique_ptr<DeviceModel> mOwnedDevice;
+    std::vector<DeviceModel*> mDevices;
+    SimulatedBus mBus;
+    I2C_HandleTypeDef mHandle{&mBus, {}, HAL_I2C_STATE_READY, HAL_I2C_ERROR_NONE};
+    CRC_HandleTypeDef mCRC{};
+    uint16_t mPagesPerRecord{};
+    std::vector<std::vector<uint8_t>> mValues;
+    std::vector<uint32_t> mSequences;
+    std::vector<bool> mDirty;
+};
+
+struct Worker {
+    pid_t pid;
+    int pipe;
+    size_t scenario;
+};
+
+static auto startWorker(const Scenario& scenario, size_t index) -> Worker {
+    int descriptors[2];
+    if(pipe(descriptors) != 0) {
+        return {-1, -1, index};
+    }
+    auto pid = fork();
+    if(pid == 0) {
+        close(descriptors[0]);
+        auto result = Simulation(scenario).run();
+        auto written = write(descriptors[1], &result, sizeof(result));
+        _exit(written == sizeof(result) ? 0 : 1);
+    }
+    close(descriptors[1]);
+    return {pid, descriptors[0], index};
+}
+
+static auto finishWorker(const Worker& worker) -> Result {
+    Result result{};
+    if(worker.pid > 0) {
+        if(read(worker.pipe, &result, sizeof(result)) != sizeof(result)) {
+            result = Result{};
+        }
+        close(worker.pipe);
+        waitpid(worker.pid, nullptr, 0);
+    }
+    return result;
+}
+
+int main(int argc, char** argv) {
+    auto jobs = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<Scenario> scenarios;
+    for(int i = 1; i < argc; ++i) {
+        if(strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            jobs = std::max(1, atoi(argv[++i]));
+        } else {
+            scenarios.push_back(parseScenario(argv[i]));
+        }
+    }
+    if(scenarios.empty()) {
+        for(auto text : {"period=60", "period=60,slots=8", "period=60,cache=3600", "period=10,scale=10", "period=10,slots=16,scale=10"}) {
+            scenarios.push_back(parseScenario(text));
+        }
+    }
+    std::vector<Result> results(scenarios.size());
+    std::vector<Worker> running;
+    size_t next = 0;
+    while(next < scenarios.size() || !running.empty()) {
+        while(next < scenarios.size() && running.size() < jobs) {
+            running.push_back(startWorker(scenarios[next], next));
+            ++next;
+        }
+        // Results come back in order of submission, the slowest one limits the batch anyway
+        auto worker = running.front();
+        running.erase(running.begin());
+        results[worker.scenario] = finishWorker(worker);
+    }
+    printf("%-40s %8s %10s %11s %9s %9s %6s %8s\n", "scenario", "result", "years", "projection",
+           "writes", "max cell", "stuck", "host s");
+    for(size_t i = 0; i < scenarios.size(); ++i) {
+        auto& result = results[i];
+        if(!result.isValid) {
+            printf("%-40s %8s\n", scenarios[i].name.c_str(), "invalid");
+            continue;
+        }
+        printf("%-40s %8s %10.2f %11.1f %9llu %9u %6u %8.1f\n", scenarios[i].name.c_str(),
+               result.isFailed ? "FAILED" : "ok", result.isFailed ? result.failureYears : result.simulatedYears,
+               result.wearOutYears, static_cast<unsigned long long>(result.writes), result.maxCellWrites,
+               result.stuckCells, result.hostSeconds);
+    }
+    printf("\nyears: time of the first lost record, or the simulated time when none was lost\n");
+    printf("projection: years until the weakest written cell reaches its endurance at the simulated rate\n");
+    return 0;
+}
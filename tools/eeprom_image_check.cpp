@@ -0,0 +1,139 @@
+// Checks the devices of a MappedImage against the file behind the mapping:
+// page writes wrap within the page, the write cycle holds off the next access,
+// the driver works on a slice and private mappings leave the file alone.
+// Build: g++ -std=c++17 -O2 -I.. -I../host ../EEPROM.cpp ../EEPROM_Trace.cpp ../EEPROM_Capture.cpp
+//        ../host/*.cpp eeprom_image_check.cpp -o eeprom_image_check
+// Usage: eeprom_image_check [directory], the image is a temporary file in it
+#include "EEPROM.h"
+#include "HostClock.h"
+#include "MappedImage.h"
+#include "SimulatedBus.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+static constexpr uint32_t sCapacity = 4096;
+static constexpr uint16_t sPageSize = 32;
+static constexpr uint32_t sWriteCycleMicroseconds = 5000;
+static constexpr uint32_t sDeviceCount = 2;
+
+static int sFailures = 0;
+
+static void check(bool isPassed, const char* what) {
+    printf("%-60s %s\n", what, isPassed ? "ok" : "FAILED");
+    sFailures += !isPassed;
+}
+
+// Straight from the file, not through the mapping
+static auto readFile(const std::string& path, uint32_t offset, uint32_t size) -> std::vector<uint8_t> {
+    std::vector<uint8_t> bytes(size);
+    auto file = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if(file < 0 || pread(file, bytes.data(), size, offset) != static_cast<ssize_t>(size)) {
+        bytes.clear();
+    }
+    if(file >= 0) {
+        close(file);
+    }
+    return bytes;
+}
+
+static void checkWrap(const std::string& path) {
+    MappedImage image(path.c_str(), sCapacity, sPageSize, true, sWriteCycleMicroseconds);
+    check(image.isOpen() && image.getDeviceCount() == sDeviceCount, "image maps every device");
+    if(!image.isOpen()) {
+        return;
+    }
+    auto& device = image.getDevice(1);
+    uint8_t bytes[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+    // 4 bytes before the end of page 2, the rest wraps to its start
+    auto address = static_cast<uint16_t>(3 * sPageSize - 4);
+    check(device.write(address, bytes, sizeof(bytes), 0), "write accepted");
+    check(device.getMemory() == image.getDevice(0).getMemory() + sCapacity, "device 1 works on its slice of the mapping");
+    check(!device.write(address, bytes, sizeof(bytes), sWriteCycleMicroseconds - 1), "write during the write cycle refused");
+    check(device.isBusy(sWriteCycleMicroseconds - 1) && !device.isBusy(sWriteCycleMicroseconds), "busy for exactly the write cycle");
+    uint8_t longBytes[sPageSize + 4];
+    for(uint16_t i = 0; i < sizeof(longBytes); ++i) {
+        longBytes[i] = static_cast<uint8_t>(0x40 + i);
+    }
+    // Longer than a page: only the last page size bytes land
+    check(device.write(4 * sPageSize, longBytes, sizeof(longBytes), sWriteCycleMicroseconds), "long write accepted");
+    check(image.sync(), "sync");
+    auto file = readFile(path, sCapacity, sCapacity);
+    auto isWrapped = file.size() == sCapacity && memcmp(&file[address], bytes, 4) == 0 &&
+                     memcmp(&file[2 * sPageSize], bytes + 4, 4) == 0 && file[2 * sPageSize + 4] == 0xFF;
+    check(isWrapped, "page write wraps within the page, in the file");
+    auto isLongWrapped = file.size() == sCapacity && memcmp(&file[4 * sPageSize + 4], longBytes + 4, sPageSize - 4) == 0 &&
+                         memcmp(&file[4 * sPageSize], longBytes + sPageSize, 4) == 0 && file[5 * sPageSize] == 0xFF;
+    check(isLongWrapped, "long page write keeps the last page size bytes, in the file");
+    auto first = readFile(path, 0, sCapacity);
+    check(first.size() == sCapacity && first[address] == 0xFF, "device 0 untouched");
+}
+
+static void checkDriver(const std::string& path) {
+    MappedImage image(path.c_str(), sCapacity, sPageSize, true, sWriteCycleMicroseconds);
+    if(!image.isOpen()) {
+        check(false, "image maps for the driver");
+        return;
+    }
+    SimulatedBus bus(400000);
+    I2C_HandleTypeDef handle{&bus, {}, HAL_I2C_STATE_READY, HAL_I2C_ERROR_NONE};
+    CRC_HandleTypeDef crc{};
+    HostClock::set(0);
+    for(uint8_t i = 0; i < sDeviceCount; ++i) {
+        uint16_t address = 0xA0 | (i << 1);
+        bus.attach(address, image.getDevice(i));
+        auto config = EEPROM_makeDefaultConfig(&handle, &crc);
+        config.deviceAddress = address;
+        config.pageSize = sPageSize;
+        check(EEPROM_InitDevice(i, config) == EEPROM_Status_Sucess, "driver initialized on a slice");
+    }
+    uint8_t record[40];
+    for(uint16_t i = 0; i < sizeof(record); ++i) {
+        record[i] = static_cast<uint8_t>(i * 7);
+    }
+    auto start = HostClock::now();
+    check(EEPROM_WriteDevice(1, 10, record, sizeof(record)) == EEPROM_Status_Sucess, "driver write to device 1");
+    uint8_t readBack[sizeof(record)]{};
+    check(EEPROM_ReadDevice(1, 10, readBack, sizeof(readBack)) == EEPROM_Status_Sucess, "driver read from device 1");
+    check(memcmp(record, readBack, sizeof(record)) == 0, "record reads back");
+    // The record and its CRC take 3 pages, the read waits for the last write cycle
+    auto cycles = image.getDevice(1).getWriteCycles();
+    check(cycles == 3 && HostClock::now() - start >= cycles * sWriteCycleMicroseconds, "driver waits out every write cycle");
+    image.sync();
+    auto file = readFile(path, sCapacity + 10 * sPageSize, sizeof(record));
+    check(file.size() == sizeof(record) && memcmp(file.data(), record, sizeof(record)) == 0, "driver write is in the file");
+}
+
+static void checkPrivate(const std::string& path) {
+    auto before = readFile(path, 0, sCapacity);
+    MappedImage image(path.c_str(), sCapacity, sPageSize, false, 0);
+    uint8_t bytes[4] = {0xDE, 0xAD, 0xBE, 0xEF};
+    check(image.isOpen() && image.getDevice(0).write(0, bytes, sizeof(bytes), 0), "write to a private mapping");
+    check(memcmp(image.getDevice(0).getMemory(), bytes, sizeof(bytes)) == 0, "private mapping sees the write");
+    check(readFile(path, 0, sCapacity) == before, "file left as it was");
+}
+
+int main(int argc, char** argv) {
+    auto path = std::string(argc > 1 ? argv[1] : "/tmp") + "/eeprom_image_XXXXXX";
+    auto file = mkstemp(path.data());
+    if(file < 0) {
+        fprintf(stderr, "can't create %s\n", path.c_str());
+        return 2;
+    }
+    std::vector<uint8_t> erased(sCapacity * sDeviceCount, 0xFF);
+    auto written = write(file, erased.data(), erased.size());
+    close(file);
+    if(written != static_cast<ssize_t>(erased.size())) {
+        unlink(path.c_str());
+        return 2;
+    }
+    checkWrap(path);
+    checkDriver(path);
+    checkPrivate(path);
+    unlink(path.c_str());
+    printf("\n%d failed\n", sFailures);
+    return sFailures == 0 ? 0 : 1;
+}
@@ -0,0 +1,217 @@
+// Measures the driver against a real chip behind /dev/i2c-N, or against the
+// file-backed stand-in when no hardware is around. The clock runs in real time,
+// every HAL call becomes one I2C_RDWR ioctl. Reports throughput and the
+// system calls spent per operation, write cycle polls included.
+// Build: g++ -std=c++17 -O2 -I.. -I../host ../EEPROM.cpp ../EEPROM_Prefetch.cpp ../EEPROM_Trace.cpp
+//        ../EEPROM_Capture.cpp ../host/*.cpp eeprom_linux_bench.cpp -o eeprom_linux_bench
+// Usage: eeprom_linux_bench <adapter> [key=value...]
+// adapter is /dev/i2c-N or file:<image>. Keys:
+//   address=0x50 (7-bit)  page=64  count=50  first=0 (page)  sizes=16,64,256
+//   capacity=32768  cycle=5000 (us, stand-in only)  scan=256 (pages, 0 skips it)
+// The scan reads pages in order one at a time, directly and through EEPROM_Prefetch.
+// The benchmark overwrites the pages it uses.
+#include "EEPROM.h"
+#include "EEPROM_Prefetch.h"
+#include "FileI2CDevice.h"
+#include "HostClock.h"
+#include "LinuxI2CBus.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct Options {
+    std::string adapter;
+    uint16_t address = 0x50;
+    uint16_t pageSize = 64;
+    uint32_t count = 50;
+    uint16_t firstPage = 0;
+    std::vector<uint16_t> sizes{16, 64, 256};
+    uint32_t capacity = 32768;
+    uint32_t writeCycleMicroseconds = 5000;
+    uint32_t scanPages = 256;
+};
+
+static auto parseOptions(int argc, char** argv, Options& options) -> bool {
+    if(argc < 2) {
+        return false;
+    }
+    options.adapter = argv[1];
+    for(int i = 2; i < argc; ++i) {
+        std::string argument = argv[i];
+        auto separator = argument.find('=');
+        if(separator == std::string::npos) {
+            return false;
+        }
+        auto key = argument.substr(0, separator);
+        auto value = argument.substr(separator + 1);
+        auto number = strtoul(value.c_str(), nullptr, 0);
+        if(key == "address") {
+            options.address = static_cast<uint16_t>(number);
+        } else if(key == "page") {
+            options.pageSize = static_cast<uint16_t>(number);
+        } else if(key == "count") {
+            options.count = static_cast<uint32_t>(number);
+        } else if(key == "first") {
+            options.firstPage = static_cast<uint16_t>(number);
+        } else if(key == "capacity") {
+            options.capacity = static_cast<uint32_t>(number);
+        } else if(key == "cycle") {
+            options.writeCycleMicroseconds = static_cast<uint32_t>(number);
+        } else if(key == "scan") {
+            options.scanPages = static_cast<uint32_t>(number);
+        } else if(key == "sizes") {
+            options.sizes.clear();
+            for(auto* token = strtok(&value[0], ","); token != nullptr; token = strtok(nullptr, ",")) {
+                options.sizes.push_back(static_cast<uint16_t>(strtoul(token, nullptr, 0)));
+            }
+        } else {
+            return false;
+        }
+    }
+    return !options.sizes.empty() && options.count != 0;
+}
+
+class Bench {
+public:
+    Bench(const Options& options, LinuxI2CBus& bus) : mOptions(options), mBus(bus) {
+        mHandle.Instance = &mBus;
+    }
+
+    auto init() -> bool {
+        auto config = EEPROM_makeDefaultConfig(&mHandle, &mCRC);
+        config.deviceAddress = static_cast<uint16_t>(mOptions.address << 1);
+        config.pageSize = mOptions.pageSize;
+        if(EEPROM_Init(config) != EEPROM_Status_Sucess) {
+            return false;
+        }
+        return EEPROM_Prefetch_Init(EEPROM_PrefetchConfig{&mCRC, 0}) == EEPROM_Status_Sucess;
+    }
+
+    void run(const char* name, uint16_t size, bool isWrite, bool isAsync) {
+        std::vector<uint8_t> bytes(size);
+        auto pages = static_cast<uint16_t>(isAsync ? (size + mOptions.pageSize - 1) / mOptions.pageSize
+                                                   : EEPROM_getBuffersPagesCount(size));
+        auto transfers = mBus.getTransfers();
+        auto nacks = mBus.getNacks();
+        uint32_t failed = 0;
+        auto start = std::chrono::steady_clock::now();
+        for(uint32_t i = 0; i < mOptions.count; ++i) {
+            for(auto& byte : bytes) {
+                byte = static_cast<uint8_t>(rand());
+            }
+            auto status = isAsync ? runAsync(bytes, isWrite, mOptions.firstPage) : runBlocking(bytes, isWrite);
+            failed += status != EEPROM_Status_Sucess;
+        }
+        auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        auto operations = static_cast<double>(mOptions.count);
+        printf("%-16s %6u %6u %10.1f %10.0f %10.2f %8.2f %7u\n", name, size, pages, operations / seconds,
+               operations * size / seconds, (mBus.getTransfers() - transfers) / operations,
+               (mBus.getNacks() - nacks) / operations, failed);
+    }
+
+    // One page per read from the first page on, the prefetcher reads ahead in windows
+    void runScan(const char* name, bool isPrefetched) {
+        std::vector<uint8_t> bytes(mOptions.pageSize);
+        EEPROM_Prefetch_Invalidate();
+        auto transfers = mBus.getTransfers();
+        auto nacks = mBus.getNacks();
+        uint32_t failed = 0;
+        auto start = std::chrono::steady_clock::now();
+        for(uint32_t i = 0; i < mOptions.scanPages; ++i) {
+            auto page = static_cast<uint16_t>(mOptions.firstPage + i);
+            auto status = isPrefetched ? EEPROM_Prefetch_ReadRaw(page, bytes.data(), mOptions.pageSize)
+                                       : runAsync(bytes, false, page);
+            failed += status != EEPROM_Status_Sucess;
+        }
+        auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        auto operations = static_cast<double>(mOptions.scanPages);
+        printf("%-16s %6u %6u %10.1f %10.0f %10.2f %8.2f %7u\n", name, mOptions.pageSize, 1u, operations / seconds,
+               operations * mOptions.pageSize / seconds, (mBus.getTransfers() - transfers) / operations,
+               (mBus.getNacks() - nacks) / operations, failed);
+        printf("%-16s %llu transfers for %u pages\n", "", static_cast<unsigned long long>(mBus.getTransfers() - transfers),
+               mOptions.scanPages);
+    }
+
+private:
+    // CRC protected, the driver waits the fixed write delay after every page
+    auto runBlocking(std::vector<uint8_t>& bytes, bool isWrite) -> EEPROM_Status {
+        auto size = static_cast<uint16_t>(bytes.size());
+        if(isWrite) {
+            return EEPROM_Write(mOptions.firstPage, bytes.data(), size);
+        }
+        return EEPROM_Read(mOptions.firstPage, bytes.data(), size);
+    }
+
+    // Raw pages, the end of the write cycle is found by ACK polling
+    auto runAsync(std::vector<uint8_t>& bytes, bool isWrite, uint16_t page) -> EEPROM_Status {
+        EEPROM_Operation operation{};
+        auto size = static_cast<uint16_t>(bytes.size());
+        auto status = isWrite ? EEPROM_WriteDeviceRawAsync(0, &operation, page, bytes.data(), size)
+                              : EEPROM_ReadDeviceRawAsync(0, &operation, page, bytes.data(), size);
+        if(status != EEPROM_Status_Sucess) {
+            return status;
+        }
+        while(operation.status == EEPROM_Status_Pending) {
+            EEPROM_Step();
+            if(operation.status == EEPROM_Status_Pending) {
+                __WFI();
+            }
+        }
+        return operation.status;
+    }
+
+    const Options& mOptions;
+    LinuxI2CBus& mBus;
+    I2C_HandleTypeDef mHandle{};
+    CRC_HandleTypeDef mCRC{};
+};
+
+int main(int argc, char** argv) {
+    Options options;
+    if(!parseOptions(argc, argv, options)) {
+        fprintf(stderr, "Usage: %s </dev/i2c-N | file:image> [address=0x50] [page=64] [count=50] [first=0] "
+                        "[sizes=16,64,256] [capacity=32768] [cycle=5000] [scan=256]\n", argv[0]);
+        return 1;
+    }
+    std::unique_ptr<I2CTransport> transport;
+    if(options.adapter.rfind("file:", 0) == 0) {
+        auto device = std::make_unique<FileI2CDevice>(options.adapter.c_str() + 5, options.address, options.capacity,
+                                                      options.pageSize, options.writeCycleMicroseconds);
+        if(!device->isOpen()) {
+            fprintf(stderr, "Can't open %s\n", options.adapter.c_str() + 5);
+            return 1;
+        }
+        transport = std::move(device);
+    } else {
+        auto adapter = std::make_unique<LinuxI2CAdapter>(options.adapter.c_str());
+        if(!adapter->isOpen()) {
+            fprintf(stderr, "Can't open %s\n", options.adapter.c_str());
+            return 1;
+        }
+        transport = std::move(adapter);
+    }
+    HostClock::useRealTime(true);
+    LinuxI2CBus bus{*transport};
+    Bench bench{options, bus};
+    if(!bench.init()) {
+        fprintf(stderr, "Can't initialize the driver\n");
+        return 1;
+    }
+    printf("%-16s %6s %6s %10s %10s %10s %8s %7s\n", "operation", "bytes", "pages", "ops/s", "bytes/s",
+           "calls/op", "nacks/op", "failed");
+    for(auto size : options.sizes) {
+        bench.run("write blocking", size, true, false);
+        bench.run("read blocking", size, false, false);
+        bench.run("write async", size, true, true);
+        bench.run("read async", size, false, true);
+    }
+    if(options.scanPages != 0) {
+        bench.runScan("scan direct", false);
+        bench.runScan("scan prefetch", true);
+    }
+    return 0;
+}
@@ -0,0 +1,392 @@
+// Replays a workload recorded with EEPROM_Capture_Drain() against simulated
+// devices through the real driver, once per driver configuration.
+// Build: g++ -std=c++17 -O2 -I.. -I../host ../EEPROM.cpp ../EEPROM_Power.cpp ../EEPROM_Trace.cpp
+//        ../EEPROM_Capture.cpp ../host/*.cpp eeprom_replay.cpp -o eeprom_replay
+// Usage: eeprom_replay <capture.bin> [configuration...]
+// A configuration is a comma separated list of key=value:
+//   mode=blocking|async|deferred  page=64  speed=400000  defer=1000 (ms)
+//   capacity=32768  devpage=64  cycle=5000 (us)  image=<path>  sync=0
+// image maps a file holding capacity bytes per device back to back, chip i of
+// the capture works on slice i. The mapping is private, every configuration
+// starts from the file contents, unless sync=1 writes the results back to it.
+#include "EEPROM.h"
+#include "EEPROM_Capture.h"
+#include "EEPROM_Power.h"
+#include "HostClock.h"
+#include "MappedImage.h"
+#include "SimulatedBus.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <list>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+enum class Mode {
+    Blocking,
+    Async,
+    Deferred
+};
+
+struct Configuration {
+    std::string name;
+    Mode mode = Mode::Blocking;
+    uint16_t pageSize = 64;
+    uint32_t speedHz = 400000;
+    uint32_t deferMilliseconds = 1000;
+    uint32_t capacity = 32768;
+    uint16_t devicePageSize = 64;
+    uint32_t writeCycleMicroseconds = 5000;
+    std::string image;
+    bool isSynced = false;
+};
+
+struct Result {
+    uint64_t operations = 0;
+    uint64_t failures = 0;
+    uint64_t writeCycles = 0;
+    uint64_t busMicroseconds = 0;
+    uint64_t elapsedMicroseconds = 0;
+    std::vector<uint64_t> latencies;
+    uint32_t maxPageWrites = 0;
+    double meanPageWrites = 0;
+    uint32_t touchedPages = 0;
+};
+
+struct PendingOperation {
+    EEPROM_Operation operation;
+    uint64_t submitted;
+};
+
+static constexpr uint64_t sIdleStepMicroseconds = 1000;
+
+static auto parseConfiguration(const std::string& text) -> Configuration {
+    Configuration configuration;
+    configuration.name = text;
+    size_t start = 0;
+    while(start < text.size()) {
+        auto end = text.find(',', start);
+        auto item = text.substr(start, end == std::string::npos ? std::string::npos : end - start);
+        start = end == std::string::npos ? text.size() : end + 1;
+        auto separator = item.find('=');
+        if(separator == std::string::npos) {
+            continue;
+        }
+        auto key = item.substr(0, separator);
+        auto value = item.substr(separator + 1);
+        auto number = strtoul(value.c_str(), nullptr, 0);
+        if(key == "mode") {
+            configuration.mode = value == "async" ? Mode::Async : value == "deferred" ? Mode::Deferred : Mode::Blocking;
+        } else if(key == "page") {
+            configuration.pageSize = static_cast<uint16_t>(number);
+        } else if(key == "speed") {
+            configuration.speedHz = number;
+        } else if(key == "defer") {
+            configuration.deferMilliseconds = number;
+        } else if(key == "capacity") {
+            configuration.capacity = number;
+        } else if(key == "devpage") {
+            configuration.devicePageSize = static_cast<uint16_t>(number);
+        } else if(key == "cycle") {
+            configuration.writeCycleMicroseconds = number;
+        } else if(key == "image") {
+            configuration.image = value;
+        } else if(key == "sync") {
+            configuration.isSynced = number != 0;
+        } else {
+            fprintf(stderr, "unknown key %s\n", key.c_str());
+        }
+    }
+    return configuration;
+}
+
+static auto loadCapture(const char* path, std::vector<EEPROM_CaptureRecord>& records) -> bool {
+    std::ifstream file(path, std::ios::binary);
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    size_t offset = 0;
+    uint64_t dropped = 0;
+    while(offset + sizeof(EEPROM_CaptureHeader) <= data.size()) {
+        EEPROM_CaptureHeader header{};
+        memcpy(&header, data.data() + offset, sizeof(header));
+        if(header.magic != EEPROM_CAPTURE_MAGIC || header.version != EEPROM_CAPTURE_VERSION || 
+           header.recordSize != sizeof(EEPROM_CaptureRecord)) {
+            fprintf(stderr, "%s: bad drain header at offset %zu\n", path, offset);
+            return false;
+        }
+        offset += sizeof(header);
+        dropped += header.dropped;
+        for(uint16_t i = 0; i < header.count && offset + sizeof(EEPROM_CaptureRecord) <= data.size(); ++i) {
+            EEPROM_CaptureRecord record{};
+            memcpy(&record, data.data() + offset, sizeof(record));
+            records.push_back(record);
+            offset += sizeof(record);
+        }
+    }
+    if(dropped != 0) {
+        fprintf(stderr, "warning: %llu records were dropped on the device\n", static_cast<unsigned long long>(dropped));
+    }
+    return true;
+}
+
+class Replay {
+public:
+    Replay(const Configuration& configuration, const std::vector<EEPROM_CaptureRecord>& records)
+        : mConfiguration(configuration), mRecords(records), mBus(configuration.speedHz) {
+    }
+
+    auto run() -> Result {
+        HostClock::set(0);
+        if(!setupDevices()) {
+            return mResult;
+        }
+        auto firstTick = mRecords.empty() ? 0 : mRecords.front().tick;
+        for(auto& record : mRecords) {
+            waitUntil((record.tick - firstTick) * 1000ull);
+            execute(record);
+        }
+        EEPROM_Power_Flush();
+        drain();
+        mResult.elapsedMicroseconds = HostClock::now();
+        mResult.busMicroseconds = mBus.getBusMicroseconds();
+        collectWear();
+        if(mImage && mConfiguration.isSynced && !mImage->sync()) {
+            fprintf(stderr, "can't write %s back\n", mConfiguration.image.c_str());
+        }
+        return mResult;
+    }
+
+private:
+    auto setupDevices() -> bool {
+        if(!mConfiguration.image.empty()) {
+            mImage = std::make_unique<MappedImage>(mConfiguration.image.c_str(), mConfiguration.capacity, 
+                                                   mConfiguration.devicePageSize, mConfiguration.isSynced,
+                                                   mConfiguration.writeCycleMicroseconds);
+            if(!mImage->isOpen()) {
+                fprintf(stderr, "can't map %s\n", mConfiguration.image.c_str());
+                return false;
+            }
+        }
+        for(auto& record : mRecords) {
+            if(mDeviceIndexes.count(record.chip) != 0) {
+                continue;
+            }
+            if(mDeviceIndexes.size() == EEPROM_MAX_DEVICES) {
+                fprintf(stderr, "more chips than EEPROM_MAX_DEVICES\n");
+                return false;
+            }
+            auto index = static_cast<uint8_t>(mDeviceIndexes.size());
+            mDeviceIndexes[record.chip] = index;
+            if(mImage && index >= mImage->getDeviceCount()) {
+                fprintf(stderr, "%s holds %u devices, chip %u has no slice\n", mConfiguration.image.c_str(), 
+                        mImage->getDeviceCount(), record.chip);
+                return false;
+            }
+            if(mImage) {
+                mDevices.push_back(&mImage->getDevice(index));
+            } else {
+                mOwnedDevices.push_back(std::make_unique<DeviceModel>(mConfiguration.capacity, mConfiguration.devicePageSize, 
+                                                                      mConfiguration.writeCycleMicroseconds));
+                mDevices.push_back(mOwnedDevices.back().get());
+            }
+            uint16_t address = 0xA0 | (record.chip << 1);
+            mBus.attach(address, *mDevices.back());
+            auto config = EEPROM_makeDefaultConfig(&mHandle, &mCRC);
+            config.deviceAddress = address;
+            config.pageSize = mConfiguration.pageSize;
+            if(EEPROM_InitDevice(index, config) != EEPROM_Status_Sucess) {
+                fprintf(stderr, "can't initialize device %u\n", index);
+                return false;
+            }
+        }
+        if(mConfiguration.mode == Mode::Deferred) {
+            auto profile = EEPROM_Power_makeDefaultProfile();
+            profile.busSpeedHz = mConfiguration.speedHz;
+            profile.sleepOnWait = 0;
+            EEPROM_Power_Init(profile);
+        }
+        return true;
+    }
+
+    // Lets the queued work progress while the device was idle between calls
+    void waitUntil(uint64_t time) {
+        while(HostClock::now() < time) {
+            EEPROM_Step();
+            collectCompleted();
+            if(EEPROM_isIdle() && EEPROM_Power_getDeferredCount() == 0) {
+                HostClock::set(time);
+                break;
+            }
+            HostClock::advance(std::min<uint64_t>(sIdleStepMicroseconds, time - HostClock::now()));
+        }
+    }
+
+    void execute(const EEPROM_CaptureRecord& record) {
+        auto device = mDeviceIndexes[record.chip];
+        auto& buffer = getBuffer(record);
+        auto kind = record.kind & ~EEPROM_CaptureKind_Async;
+        auto isWrite = kind == EEPROM_CaptureKind_Write || kind == EEPROM_CaptureKind_WriteRaw;
+        auto isRaw = kind == EEPROM_CaptureKind_ReadRaw || kind == EEPROM_CaptureKind_WriteRaw;
+        if(isWrite) {
+            // New contents every time, like a record that changed
+            for(auto& byte : buffer) {
+                byte = static_cast<uint8_t>(rand());
+            }
+        }
+        ++mResult.operations;
+        if(mConfiguration.mode == Mode::Deferred && isWrite && !isRaw) {
+            auto status = EEPROM_Power_WriteDeferred(device, record.page, buffer.data(), record.size, mConfiguration.deferMilliseconds);
+            mResult.failures += status != EEPROM_Status_Sucess;
+            mResult.latencies.push_back(0);
+            return;
+        }
+        if(mConfiguration.mode == Mode::Async) {
+            submit(device, record, buffer, isWrite, isRaw);
+            return;
+        }
+        // Blocking calls are refused while the queue of the device is not empty
+        while(!EEPROM_isDeviceIdle(device)) {
+            EEPROM_Step();
+            HostClock::advance(1);
+        }
+        auto start = HostClock::now();
+        EEPROM_Status status;
+        if(isRaw) {
+            submit(device, record, buffer, isWrite, isRaw);
+            drain();
+            return;
+        }
+        if(isWrite) {
+            status = EEPROM_WriteDevice(device, record.page, buffer.data(), record.size);
+        } else {
+            status = EEPROM_ReadDevice(device, record.page, buffer.data(), record.size);
+        }
+        mResult.failures += status != EEPROM_Status_Sucess;
+        mResult.latencies.push_back(HostClock::now() - start);
+    }
+
+    void submit(uint8_t device, const EEPROM_CaptureRecord& record, std::vector<uint8_t>& buffer, bool isWrite, bool isRaw) {
+        mPending.push_back(PendingOperation{});
+        auto& pending = mPending.back();
+        pending.submitted = HostClock::now();
+        auto status = EEPROM_Status_Sucess;
+        if(isRaw && record.offset != 0) {
+            // Byte operation, at the same offset into the page of the configured size
+            auto address = static_cast<uint16_t>(record.page * mConfiguration.pageSize + record.offset);
+            status = isWrite ? EEPROM_WriteDeviceBytesAsync(device, &pending.operation, address, buffer.data(), record.size)
+                             : EEPROM_ReadDeviceBytesAsync(device, &pending.operation, address, buffer.data(), record.size);
+        } else {
+            auto submitFunction = isWrite ? (isRaw ? EEPROM_WriteDeviceRawAsync : EEPROM_WriteDeviceAsync)
+                                          : (isRaw ? EEPROM_ReadDeviceRawAsync : EEPROM_ReadDeviceAsync);
+            status = submitFunction(device, &pending.operation, record.page, buffer.data(), record.size);
+        }
+        if(status != EEPROM_Status_Sucess) {
+            ++mResult.failures;
+            mPending.pop_back();
+        }
+    }
+
+    void drain() {
+        while(!EEPROM_isIdle()) {
+            EEPROM_Step();
+            collectCompleted();
+            HostClock::advance(1);
+        }
+        collectCompleted();
+    }
+
+    void collectCompleted() {
+        for(auto pending = mPending.begin(); pending != mPending.end();) {
+            if(pending->operation.status == EEPROM_Status_Pending) {
+                ++pending;
+                continue;
+            }
+            mResult.failures += pending->operation.status != EEPROM_Status_Sucess;
+            mResult.latencies.push_back(HostClock::now() - pending->submitted);
+            pending = mPending.erase(pending);
+        }
+    }
+
+    auto getBuffer(const EEPROM_CaptureRecord& record) -> std::vector<uint8_t>& {
+        auto& buffer = mBuffers[(static_cast<uint32_t>(record.chip) << 16) | record.page];
+        if(buffer.size() < record.size) {
+            buffer.resize(record.size);
+        }
+        return buffer;
+    }
+
+    void collectWear() {
+        uint64_t totalWrites = 0;
+        for(auto& device : mDevices) {
+            mResult.writeCycles += device->getWriteCycles();
+            for(auto writes : device->getPageWrites()) {
+                if(writes == 0) {
+                    continue;
+                }
+                ++mResult.touchedPages;
+                totalWrites += writes;
+                mResult.maxPageWrites = std::max(mResult.maxPageWrites, writes);
+            }
+        }
+        mResult.meanPageWrites = mResult.touchedPages ? static_cast<double>(totalWrites) / mResult.touchedPages : 0;
+    }
+
+    const Configuration& mConfiguration;
+    const std::vector<EEPROM_CaptureRecord>& mRecords;
+    SimulatedBus mBus;
+    I2C_HandleTypeDef mHandle{&mBus, {}, HAL_I2C_STATE_READY, HAL_I2C_ERROR_NONE};
+    CRC_HandleTypeDef mCRC{};
+    std::unique_ptr<MappedImage> mImage;
+    std::vector<std::unique_ptr<DeviceModel>> mOwnedDevices;
+    std::vector<DeviceModel*> mDevices;
+    std::map<uint8_t, uint8_t> mDeviceIndexes;
+    std::map<uint32_t, std::vector<uint8_t>> mBuffers;
+    std::list<PendingOperation> mPending;
+    Result mResult;
+};
+
+static auto percentile(std::vector<uint64_t>& values, double fraction) -> double {
+    if(values.empty()) {
+        return 0;
+    }
+    auto index = static_cast<size_t>(fraction * (values.size() - 1) + 0.5);
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index] / 1000.0;
+}
+
+int main(int argc, char** argv) {
+    if(argc < 2) {
+        fprintf(stderr, "usage: %s <capture.bin> [configuration...]\n", argv[0]);
+        return 2;
+    }
+    std::vector<EEPROM_CaptureRecord> records;
+    if(!loadCapture(argv[1], records)) {
+        return 1;
+    }
+    std::vector<Configuration> configurations;
+    for(int i = 2; i < argc; ++i) {
+        configurations.push_back(parseConfiguration(argv[i]));
+    }
+    if(configurations.empty()) {
+        for(auto text : {"mode=blocking,speed=100000", "mode=blocking", "mode=async", "mode=deferred,defer=1000"}) {
+            configurations.push_back(parseConfiguration(text));
+        }
+    }
+    printf("%zu operations replayed per configuration\n\n", records.size());
+    printf("%-36s %9s %9s %10s %9s %9s %9s %8s %9s\n", "configuration", "failures", "cycles", "bus ms", 
+           "p50 ms", "p99 ms", "max ms", "pages", "max wear");
+    for(auto& configuration : configurations) {
+        srand(1);
+        auto result = Replay(configuration, records).run();
+        printf("%-36s %9llu %9llu %10.1f %9.2f %9.2f %9.2f %8u %4u/%-4.0f\n", configuration.name.c_str(),
+               static_cast<unsigned long long>(result.failures), static_cast<unsigned long long>(result.writeCycles), 
+               result.busMicroseconds / 1000.0, percentile(result.latencies, 0.5), percentile(result.latencies, 0.99),
+               percentile(result.latencies, 1.0), result.touchedPages, result.maxPageWrites, result.meanPageWrites);
+    }
+    printf("\nmax wear: write cycles of the most written page / mean over the written pages\n");
+    return 0;
+}
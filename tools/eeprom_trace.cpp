@@ -0,0 +1,235 @@
+// Host decoder for dumps made by EEPROM_Trace_Dump()/EEPROM_Trace_DumpITM().
+// Build: g++ -std=c++17 -O2 eeprom_trace.cpp -o eeprom_trace
+// Usage: eeprom_trace <dump.bin> [--timeline]
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <string>
+#include <vector>
+
+// Same layout as EEPROM_Trace.h, the header is not included to keep the tool free of main.h
+struct TraceHeader {
+    uint32_t magic;
+    uint8_t version;
+    uint8_t recordSize;
+    uint16_t count;
+    uint32_t coreClockHz;
+};
+
+struct TraceRecord {
+    uint32_t cycles;
+    uint16_t address;
+    uint8_t event;
+    uint8_t info;
+};
+
+static_assert(sizeof(TraceHeader) == 12 && sizeof(TraceRecord) == 8, "Dump layout changed");
+
+static constexpr uint32_t sMagic = 0x52544545u;
+static constexpr uint8_t sVersion = 1;
+
+enum Event : uint8_t {
+    Event_WriteStart,
+    Event_ReadStart,
+    Event_OperationEnd,
+    Event_PageTransfer,
+    Event_CRCTransfer,
+    Event_WriteCycle,
+    Event_BusRecovery
+};
+
+static const char* sEventNames[] = {"write-start", "read-start", "end", "page", "crc", "write-cycle", "recovery"};
+static const char* sHALStatusNames[] = {"OK", "ERROR", "BUSY", "TIMEOUT"};
+static const char* sStatusNames[] = {"Success", "NotInitialized", "Busy", "Timeout", "InvalidCRC", "Error", "Pending"};
+
+struct Operation {
+    uint8_t chip;
+    bool isWrite;
+    uint16_t page;
+    uint8_t status;
+    double startUs;
+    double totalUs;
+    double transferUs;
+    double crcUs;
+    double writeCycleUs;
+    uint32_t pages;
+};
+
+class Statistics {
+public:
+    void add(double value) {
+        mValues.push_back(value);
+    }
+
+    void print(const char* name) {
+        if(mValues.empty()) {
+            return;
+        }
+        std::sort(mValues.begin(), mValues.end());
+        double sum = 0;
+        for(auto value : mValues) {
+            sum += value;
+        }
+        printf("  %-14s %7zu %10.1f %10.1f %10.1f %10.1f %12.1f\n", name, mValues.size(), 
+               sum / mValues.size(), percentile(0.5), percentile(0.99), mValues.back(), sum);
+    }
+
+private:
+    auto percentile(double fraction) const -> double {
+        auto index = static_cast<size_t>(fraction * (mValues.size() - 1) + 0.5);
+        return mValues[index];
+    }
+
+    std::vector<double> mValues;
+};
+
+static auto getEventName(uint8_t event) -> const char* {
+    return event < std::size(sEventNames) ? sEventNames[event] : "?";
+}
+
+static auto getStatusName(const TraceRecord& record) -> std::string {
+    auto code = static_cast<unsigned>(record.info & 0x1F);
+    if(record.event == Event_OperationEnd) {
+        return code < std::size(sStatusNames) ? sStatusNames[code] : std::to_string(code);
+    }
+    if(record.event == Event_PageTransfer || record.event == Event_CRCTransfer || record.event == Event_WriteCycle) {
+        return code < std::size(sHALStatusNames) ? sHALStatusNames[code] : std::to_string(code);
+    }
+    if(record.event == Event_BusRecovery) {
+        return code != 0 ? "released" : "stuck";
+    }
+    return "";
+}
+
+int main(int argc, char** argv) {
+    if(argc < 2) {
+        fprintf(stderr, "usage: %s <dump.bin> [--timeline]\n", argv[0]);
+        return 2;
+    }
+    auto printTimeline = argc > 2 && strcmp(argv[2], "--timeline") == 0;
+    std::ifstream file(argv[1], std::ios::binary);
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if(data.size() < sizeof(TraceHeader)) {
+        fprintf(stderr, "%s: too short for a trace dump\n", argv[1]);
+        return 1;
+    }
+    TraceHeader header{};
+    memcpy(&header, data.data(), sizeof(header));
+    if(header.magic != sMagic || header.version != sVersion || header.recordSize != sizeof(TraceRecord)) {
+        fprintf(stderr, "%s: not a version %u trace dump\n", argv[1], sVersion);
+        return 1;
+    }
+    auto available = (data.size() - sizeof(header)) / sizeof(TraceRecord);
+    if(available < header.count) {
+        fprintf(stderr, "warning: dump truncated, %zu of %u records\n", available, header.count);
+    }
+    auto count = std::min<size_t>(available, header.count);
+    auto cyclesPerUs = header.coreClockHz / 1e6;
+    if(cyclesPerUs <= 0) {
+        cyclesPerUs = 1;
+    }
+
+    // Time is unwrapped from the 32-bit cycle counter, phases are attributed per chip
+    double nowUs = 0;
+    uint32_t lastCycles = 0;
+    std::map<uint8_t, double> lastChipUs;
+    std::map<uint8_t, Operation> openOperations;
+    std::vector<Operation> operations;
+    Statistics transferStatistics, crcStatistics, writeCycleStatistics;
+    uint32_t failedTransfers = 0;
+    uint32_t busRecoveries = 0;
+
+    if(printTimeline) {
+        printf("%12s %10s chip %-11s %7s %s\n", "time us", "+us", "event", "address", "status");
+    }
+    for(size_t i = 0; i < count; ++i) {
+        TraceRecord record{};
+        memcpy(&record, data.data() + sizeof(header) + i * sizeof(record), sizeof(record));
+        if(i != 0) {
+            nowUs += static_cast<uint32_t>(record.cycles - lastCycles) / cyclesPerUs;
+        }
+        lastCycles = record.cycles;
+        uint8_t chip = record.info >> 5;
+        auto phaseUs = lastChipUs.count(chip) ? nowUs - lastChipUs[chip] : 0.0;
+        lastChipUs[chip] = nowUs;
+        if(printTimeline) {
+            printf("%12.1f %10.1f %4u %-11s %7u %s\n", nowUs, phaseUs, chip, getEventName(record.event), 
+                   record.address, getStatusName(record).c_str());
+        }
+        auto found = openOperations.find(chip);
+        auto operation = found != openOperations.end() ? &found->second : nullptr;
+        switch(record.event) {
+            case Event_WriteStart:
+            case Event_ReadStart:
+                openOperations[chip] = Operation{chip, record.event == Event_WriteStart, record.address, 0, nowUs, 0, 0, 0, 0, 0};
+                break;
+            case Event_PageTransfer:
+                transferStatistics.add(phaseUs);
+                failedTransfers += (record.info & 0x1F) != 0;
+                if(operation != nullptr) {
+                    operation->transferUs += phaseUs;
+                    ++operation->pages;
+                }
+                break;
+            case Event_CRCTransfer:
+                crcStatistics.add(phaseUs);
+                failedTransfers += (record.info & 0x1F) != 0;
+                if(operation != nullptr) {
+                    operation->crcUs += phaseUs;
+                }
+                break;
+            case Event_WriteCycle:
+                writeCycleStatistics.add(phaseUs);
+                if(operation != nullptr) {
+                    operation->writeCycleUs += phaseUs;
+                }
+                break;
+            case Event_BusRecovery:
+                ++busRecoveries;
+                break;
+            case Event_OperationEnd:
+                if(operation != nullptr) {
+                    operation->status = record.info & 0x1F;
+                    operation->totalUs = nowUs - operation->startUs;
+                    operations.push_back(*operation);
+                    openOperations.erase(found);
+                }
+                break;
+            default:
+                break;
+        }
+    }
+
+    Statistics writeStatistics, readStatistics;
+    uint32_t failedOperations = 0;
+    for(auto& operation : operations) {
+        (operation.isWrite ? writeStatistics : readStatistics).add(operation.totalUs);
+        failedOperations += operation.status != 0;
+    }
+    printf("\n%zu records, %.1f ms, %zu operations (%u failed), %u failed transfers, %u bus recoveries\n\n", 
+           count, nowUs / 1000, operations.size(), failedOperations, failedTransfers, busRecoveries);
+    printf("  %-14s %7s %10s %10s %10s %10s %12s\n", "latency us", "count", "mean", "p50", "p99", "max", "total");
+    writeStatistics.print("write");
+    readStatistics.print("read");
+    transferStatistics.print("page transfer");
+    crcStatistics.print("crc transfer");
+    writeCycleStatistics.print("write cycle");
+
+    std::sort(operations.begin(), operations.end(), [](auto& left, auto& right) { return left.totalUs > right.totalUs; });
+    printf("\nslowest operations\n");
+    printf("  %10s chip %-5s %5s %5s %10s %10s %10s %10s %s\n", "start us", "op", "page", "pages", "total", "transfer", "crc", "cycles", "status");
+    for(size_t i = 0; i < operations.size() && i < 10; ++i) {
+        auto& operation = operations[i];
+        auto other = operation.totalUs - operation.transferUs - operation.crcUs - operation.writeCycleUs;
+        printf("  %10.1f %4u %-5s %5u %5u %10.1f %10.1f %10.1f %10.1f %s%s\n", operation.startUs, operation.chip, 
+               operation.isWrite ? "write" : "read", operation.page, operation.pages, operation.totalUs, 
+               operation.transferUs, operation.crcUs, operation.writeCycleUs, 
+               operation.status < std::size(sStatusNames) ? sStatusNames[operation.status] : "?",
+               other > operation.totalUs / 2 ? " (mostly queued)" : "");
+    }
+    return 0;
+}